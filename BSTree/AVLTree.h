@@ -1,48 +1,64 @@
-#pragma once
-
-#include <vector>
-
-class AVLTree
-{
-public:
-
-    AVLTree();
-    ~AVLTree();
-    void Insert(int key);
-    void Remove(int key);
-    bool Find(int key);
-    int Height();
-    void Clear();
-    void Print();
-    std::vector<int> GetVector();
-
-private:
-
-    struct Node
-    {
-        int key;
-        Node* left;
-        Node* right;
-        unsigned char height;
-
-        Node(int key);
-        ~Node();
-    };
-
-    unsigned char Height(Node* node);
-    void FixHeight(Node* node);
-    int BalanceFactor(Node* node);
-    Node* RotateLeft(Node* p);
-    Node* RotateRight(Node* p);
-    Node* RotateRightLeft(Node* p);
-    Node* RotateLeftRight(Node* p);
-    Node* Balance(Node* node);
-    Node* Insert(Node* node, int key);
-    Node* FindMin(Node* node);
-    Node* ExcludeMin(Node* node);
-    Node* Remove(Node* node, int key);
-    void Print(Node* node);
-    void GetVector(Node* node, std::vector<int>& vec);
-
-    Node* root;
-};
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+class AVLTree
+{
+public:
+
+    AVLTree();
+    ~AVLTree();
+    void Insert(int key);
+    void Remove(int key);
+    bool Find(int key);
+    // Find of every key, descents of a group of keys are interleaved so their cache misses overlap
+    void FindBatch(const std::vector<int>& keys, std::vector<bool>& found);
+    // largest key <= key, smallest key >= key, largest key < key, smallest key > key;
+    // return false if there is no such key
+    bool Floor(int key, int& result);
+    bool Ceiling(int key, int& result);
+    bool Predecessor(int key, int& result);
+    bool Successor(int key, int& result);
+    // Floor/Ceiling of every probe, probes are sorted; found[i] tells if results[i] is set
+    void Floor(const std::vector<int>& probes, std::vector<int>& results, std::vector<bool>& found);
+    void Ceiling(const std::vector<int>& probes, std::vector<int>& results, std::vector<bool>& found);
+    int Height();
+    void Clear();
+    void Print();
+    std::vector<int> GetVector();
+    size_t MemoryUsage();
+
+private:
+
+    struct Node
+    {
+        int key;
+        Node* left;
+        Node* right;
+        unsigned char height;
+
+        Node(int key);
+        ~Node();
+    };
+
+    unsigned char Height(Node* node);
+    void FixHeight(Node* node);
+    int BalanceFactor(Node* node);
+    Node* RotateLeft(Node* p);
+    Node* RotateRight(Node* p);
+    Node* RotateRightLeft(Node* p);
+    Node* RotateLeftRight(Node* p);
+    Node* Balance(Node* node);
+    Node* Insert(Node* node, int key);
+    Node* FindMin(Node* node);
+    Node* ExcludeMin(Node* node);
+    Node* Remove(Node* node, int key);
+    Node* FloorNode(Node* node, int key, bool inclusive);
+    Node* CeilingNode(Node* node, int key, bool inclusive);
+    void Print(Node* node);
+    void GetVector(Node* node, std::vector<int>& vec);
+    size_t Size(Node* node);
+
+    Node* root;
+};
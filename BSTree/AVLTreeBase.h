@@ -0,0 +1,357 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include "Augmentation.h"
+
+// AVL balancing shared by AVLTreeIterative and AugmentedAVLTree: heights, rotations,
+// insert and remove balancing. A node is Payload (key and whatever goes with it)
+// plus links and height, empty children are nullptr. Augmentation::Update(node)
+// runs in FixHeight and on every other node whose subtree changed, children before
+// parents, so a node can keep a summary of its subtree.
+template <typename Payload, typename Augmentation = NoAugmentation>
+class AVLTreeBase
+{
+protected:
+    struct Node : Payload
+    {
+        Node* left;
+        Node* right;
+        Node* parent;
+        unsigned char height;
+    };
+
+    unsigned char Height(Node* node);
+    void FixHeight(Node* node);
+    int BalanceFactor(Node* node);
+
+    void RotateLeft(Node* p);
+    void RotateRight(Node* p);
+    void RotateRightLeft(Node* p);
+    void RotateLeftRight(Node* p);
+    // link node as a leaf under parent (root if parent is nullptr) and rebalance
+    void InsertLeaf(Node* node, Node* parent, bool left);
+    void InsertBalance(Node* node);
+    // take node's entry out of the tree, returns the node to free: node itself,
+    // or its successor whose payload was moved into node
+    Node* Unlink(Node* node);
+    void RemoveBalance(Node* node);
+    // Update of node and all its ancestors, after payload of node changed
+    void UpdateUp(Node* node);
+    Node* FindMin(Node* node);
+
+    // empty child, named as in RBTreeBase so code on top of either reads the same
+    static constexpr Node* nil = nullptr;
+    Node* root = nullptr;
+    // loop steps of insert and remove balancing so far
+    size_t rebalanceSteps = 0;
+};
+
+template <typename Payload, typename Augmentation>
+unsigned char AVLTreeBase<Payload, Augmentation>::Height(Node* node)
+{
+    if (node == nullptr)
+    {
+        return 0;
+    }
+    return node->height;
+}
+
+template <typename Payload, typename Augmentation>
+void AVLTreeBase<Payload, Augmentation>::FixHeight(Node* node)
+{
+    node->height = std::max(Height(node->left), Height(node->right)) + 1;
+    Augmentation::Update(node);
+}
+
+template <typename Payload, typename Augmentation>
+int AVLTreeBase<Payload, Augmentation>::BalanceFactor(Node* node)
+{
+    return Height(node->left) - Height(node->right);
+}
+
+template <typename Payload, typename Augmentation>
+void AVLTreeBase<Payload, Augmentation>::RotateLeft(Node* p)
+{
+    assert(p != nullptr);
+    assert(p->right != nullptr);
+    assert(root->parent == nullptr);
+
+    Node* q = p->right;
+
+    // p - c link
+    p->right = q->left;
+    if (p->right != nullptr)
+    {
+        p->right->parent = p;
+    }
+    // q - parent link
+    q->parent = p->parent;
+    if (q->parent == nullptr)
+    {
+        root = q;
+        assert(root->parent == nullptr);
+    }
+    else
+    {
+        if (p == p->parent->left)
+        {
+            q->parent->left = q;
+        }
+        else
+        {
+            q->parent->right = q;
+        }
+    }
+    // p - q link
+    q->left = p;
+    p->parent = q;
+
+    FixHeight(p);
+    FixHeight(q);
+}
+
+template <typename Payload, typename Augmentation>
+void AVLTreeBase<Payload, Augmentation>::RotateRight(Node* p)
+{
+    assert(p != nullptr);
+    assert(p->left != nullptr);
+    assert(root->parent == nullptr);
+
+    Node* q = p->left;
+
+    // p - c link
+    p->left = q->right;
+    if (p->left != nullptr)
+    {
+        p->left->parent = p;
+    }
+    // q - parent link
+    q->parent = p->parent;
+    if (q->parent == nullptr)
+    {
+        root = q;
+        assert(root->parent == nullptr);
+    }
+    else
+    {
+        if (p == p->parent->left)
+        {
+            q->parent->left = q;
+        }
+        else
+        {
+            q->parent->right = q;
+        }
+    }
+    // p - q link
+    q->right = p;
+    p->parent = q;
+
+    FixHeight(p);
+    FixHeight(q);
+}
+
+template <typename Payload, typename Augmentation>
+void AVLTreeBase<Payload, Augmentation>::RotateRightLeft(Node* p)
+{
+    RotateRight(p->right);
+    RotateLeft(p);
+}
+
+template <typename Payload, typename Augmentation>
+void AVLTreeBase<Payload, Augmentation>::RotateLeftRight(Node* p)
+{
+    RotateLeft(p->left);
+    RotateRight(p);
+}
+
+template <typename Payload, typename Augmentation>
+void AVLTreeBase<Payload, Augmentation>::InsertLeaf(Node* node, Node* parent, bool left)
+{
+    node->left = nullptr;
+    node->right = nullptr;
+    node->parent = parent;
+    node->height = 1;
+    Augmentation::Update(node);
+    if (parent == nullptr)
+    {
+        root = node;
+        return;
+    }
+    if (left)
+    {
+        parent->left = node;
+    }
+    else
+    {
+        parent->right = node;
+    }
+    // go up and balance tree, rotations keep node in the tree
+    InsertBalance(parent);
+}
+
+template <typename Payload, typename Augmentation>
+void AVLTreeBase<Payload, Augmentation>::InsertBalance(Node* node)
+{
+    while (node != nullptr)
+    {
+        rebalanceSteps++;
+        FixHeight(node);
+        int balance = BalanceFactor(node);
+        if (balance == 0)
+        {
+            break;
+        }
+        if (balance == 2)
+        {
+            if (BalanceFactor(node->left) > 0)
+            {
+                RotateRight(node);
+            }
+            else
+            {
+                RotateLeftRight(node);
+            }
+            break;
+        }
+        if (balance == -2)
+        {
+            if (BalanceFactor(node->right) < 0)
+            {
+                RotateLeft(node);
+            }
+            else
+            {
+                RotateRightLeft(node);
+            }
+            break;
+        }
+        node = node->parent;
+    }
+    // heights above are fixed, but subtrees of the nodes there still changed
+    if (node != nullptr)
+    {
+        UpdateUp(node->parent);
+    }
+}
+
+template <typename Payload, typename Augmentation>
+typename AVLTreeBase<Payload, Augmentation>::Node* AVLTreeBase<Payload, Augmentation>::Unlink(Node* node)
+{
+    Node* y = node;
+    Node* x = nullptr;
+    // find y and its child x nodes
+    if (node->left == nullptr)
+    {
+        x = node->right;
+    }
+    else if (node->right == nullptr)
+    {
+        x = node->left;
+    }
+    else
+    {
+        y = FindMin(node->right);
+        x = y->right;
+    }
+    // exclude y
+    if (x != nullptr)
+    {
+        x->parent = y->parent;
+    }
+    if (y->parent == nullptr)
+    {
+        root = x;
+    }
+    else
+    {
+        if (y == y->parent->left)
+        {
+            y->parent->left = x;
+        }
+        else
+        {
+            y->parent->right = x;
+        }
+    }
+    if (y != node)
+    {
+        static_cast<Payload&>(*node) = static_cast<const Payload&>(*y);
+    }
+
+    // go up and balance tree, node is an ancestor of y so this updates node too
+    RemoveBalance(y->parent);
+    return y;
+}
+
+template <typename Payload, typename Augmentation>
+void AVLTreeBase<Payload, Augmentation>::RemoveBalance(Node* node)
+{
+    while (node != nullptr)
+    {
+        rebalanceSteps++;
+        unsigned char height = node->height;
+        FixHeight(node);
+        int balance = BalanceFactor(node);
+        if (balance == 2)
+        {
+            if (BalanceFactor(node->left) >= 0)
+            {
+                RotateRight(node);
+            }
+            else
+            {
+                RotateLeftRight(node);
+            }
+            node = node->parent;
+        }
+        else if (balance == -2)
+        {
+            if (BalanceFactor(node->right) <= 0)
+            {
+                RotateLeft(node);
+            }
+            else
+            {
+                RotateRightLeft(node);
+            }
+            node = node->parent;
+        }
+        // subtree height didn't change, upper nodes are balanced
+        if (node->height == height)
+        {
+            break;
+        }
+        node = node->parent;
+    }
+    // heights above are fixed, but subtrees of the nodes there still changed
+    if (node != nullptr)
+    {
+        UpdateUp(node->parent);
+    }
+}
+
+template <typename Payload, typename Augmentation>
+void AVLTreeBase<Payload, Augmentation>::UpdateUp(Node* node)
+{
+    if constexpr (Augmentation::enabled)
+    {
+        while (node != nullptr)
+        {
+            Augmentation::Update(node);
+            node = node->parent;
+        }
+    }
+}
+
+template <typename Payload, typename Augmentation>
+typename AVLTreeBase<Payload, Augmentation>::Node* AVLTreeBase<Payload, Augmentation>::FindMin(Node* node)
+{
+    while (node->left != nullptr)
+    {
+        node = node->left;
+    }
+    return node;
+}
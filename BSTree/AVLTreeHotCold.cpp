@@ -0,0 +1,394 @@
+#include "AVLTreeHotCold.h"
+#include <algorithm>
+#include <cassert>
+
+AVLTreeHotCold::AVLTreeHotCold() :
+    root{ none },
+    freeSlots{ none },
+    size{ 0 }
+{
+}
+
+void AVLTreeHotCold::Insert(int key)
+{
+    if (root == none)
+    {
+        root = NewSlot(key);
+        return;
+    }
+
+    uint32_t parent = none;
+    uint32_t slot = root;
+    // go down and find insertion position
+    while (slot != none)
+    {
+        if (key == hot[slot].key)
+        {
+            // existing key, no structural changes
+            return;
+        }
+
+        parent = slot;
+        if (key < hot[slot].key)
+        {
+            slot = hot[slot].left;
+        }
+        else
+        {
+            slot = hot[slot].right;
+        }
+    }
+
+    // insert new node, hot and cold may move
+    slot = NewSlot(key);
+    cold[slot].parent = parent;
+    if (key < hot[parent].key)
+    {
+        hot[parent].left = slot;
+    }
+    else
+    {
+        hot[parent].right = slot;
+    }
+
+    // go up and balance tree
+    InsertBalance(parent);
+}
+
+void AVLTreeHotCold::Remove(int key)
+{
+    // find removing node
+    uint32_t node = FindSlot(key);
+    if (node == none)
+    {
+        return;
+    }
+
+    uint32_t y = node;
+    uint32_t x = none;
+    // find y and its child x nodes
+    if (hot[node].left == none)
+    {
+        x = hot[node].right;
+    }
+    else if (hot[node].right == none)
+    {
+        x = hot[node].left;
+    }
+    else
+    {
+        y = FindMin(hot[node].right);
+        x = hot[y].right;
+    }
+    // exclude y
+    uint32_t parent = cold[y].parent;
+    if (x != none)
+    {
+        cold[x].parent = parent;
+    }
+    if (parent == none)
+    {
+        root = x;
+    }
+    else
+    {
+        if (y == hot[parent].left)
+        {
+            hot[parent].left = x;
+        }
+        else
+        {
+            hot[parent].right = x;
+        }
+    }
+    if (y != node)
+    {
+        hot[node].key = hot[y].key;
+    }
+
+    // go up and balance tree
+    RemoveBalance(parent);
+
+    FreeSlot(y);
+}
+
+bool AVLTreeHotCold::Find(int key)
+{
+    return FindSlot(key) != none;
+}
+
+size_t AVLTreeHotCold::Height()
+{
+    return Height(root);
+}
+
+void AVLTreeHotCold::Clear()
+{
+    hot.clear();
+    cold.clear();
+    root = none;
+    freeSlots = none;
+    size = 0;
+}
+
+std::vector<int> AVLTreeHotCold::GetVector()
+{
+    std::vector<int> vec;
+    GetVector(root, vec);
+    return vec;
+}
+
+size_t AVLTreeHotCold::MemoryUsage()
+{
+    return size * (sizeof(HotNode) + sizeof(ColdNode));
+}
+
+// reuses a freed slot or appends one
+uint32_t AVLTreeHotCold::NewSlot(int key)
+{
+    uint32_t slot = freeSlots;
+    if (slot != none)
+    {
+        freeSlots = hot[slot].left;
+        hot[slot] = HotNode{ key, none, none };
+        cold[slot] = ColdNode{ none, 1 };
+    }
+    else
+    {
+        slot = static_cast<uint32_t>(hot.size());
+        hot.push_back(HotNode{ key, none, none });
+        cold.push_back(ColdNode{ none, 1 });
+    }
+    size++;
+    return slot;
+}
+
+void AVLTreeHotCold::FreeSlot(uint32_t slot)
+{
+    hot[slot].left = freeSlots;
+    freeSlots = slot;
+    size--;
+}
+
+unsigned char AVLTreeHotCold::Height(uint32_t slot)
+{
+    if (slot == none)
+    {
+        return 0;
+    }
+    return cold[slot].height;
+}
+
+void AVLTreeHotCold::FixHeight(uint32_t slot)
+{
+    cold[slot].height = std::max(Height(hot[slot].left), Height(hot[slot].right)) + 1;
+}
+
+int AVLTreeHotCold::BalanceFactor(uint32_t slot)
+{
+    return Height(hot[slot].left) - Height(hot[slot].right);
+}
+
+void AVLTreeHotCold::RotateLeft(uint32_t p)
+{
+    assert(p != none);
+    assert(hot[p].right != none);
+
+    uint32_t q = hot[p].right;
+
+    // p - c link
+    hot[p].right = hot[q].left;
+    if (hot[p].right != none)
+    {
+        cold[hot[p].right].parent = p;
+    }
+    // q - parent link
+    uint32_t parent = cold[p].parent;
+    cold[q].parent = parent;
+    if (parent == none)
+    {
+        root = q;
+    }
+    else
+    {
+        if (p == hot[parent].left)
+        {
+            hot[parent].left = q;
+        }
+        else
+        {
+            hot[parent].right = q;
+        }
+    }
+    // p - q link
+    hot[q].left = p;
+    cold[p].parent = q;
+
+    FixHeight(p);
+    FixHeight(q);
+}
+
+void AVLTreeHotCold::RotateRight(uint32_t p)
+{
+    assert(p != none);
+    assert(hot[p].left != none);
+
+    uint32_t q = hot[p].left;
+
+    // p - c link
+    hot[p].left = hot[q].right;
+    if (hot[p].left != none)
+    {
+        cold[hot[p].left].parent = p;
+    }
+    // q - parent link
+    uint32_t parent = cold[p].parent;
+    cold[q].parent = parent;
+    if (parent == none)
+    {
+        root = q;
+    }
+    else
+    {
+        if (p == hot[parent].left)
+        {
+            hot[parent].left = q;
+        }
+        else
+        {
+            hot[parent].right = q;
+        }
+    }
+    // p - q link
+    hot[q].right = p;
+    cold[p].parent = q;
+
+    FixHeight(p);
+    FixHeight(q);
+}
+
+void AVLTreeHotCold::RotateRightLeft(uint32_t p)
+{
+    RotateRight(hot[p].right);
+    RotateLeft(p);
+}
+
+void AVLTreeHotCold::RotateLeftRight(uint32_t p)
+{
+    RotateLeft(hot[p].left);
+    RotateRight(p);
+}
+
+void AVLTreeHotCold::InsertBalance(uint32_t slot)
+{
+    while (slot != none)
+    {
+        FixHeight(slot);
+        int balance = BalanceFactor(slot);
+        if (balance == 0)
+        {
+            break;
+        }
+        if (balance == 2)
+        {
+            if (BalanceFactor(hot[slot].left) > 0)
+            {
+                RotateRight(slot);
+            }
+            else
+            {
+                RotateLeftRight(slot);
+            }
+            break;
+        }
+        if (balance == -2)
+        {
+            if (BalanceFactor(hot[slot].right) < 0)
+            {
+                RotateLeft(slot);
+            }
+            else
+            {
+                RotateRightLeft(slot);
+            }
+            break;
+        }
+        slot = cold[slot].parent;
+    }
+}
+
+void AVLTreeHotCold::RemoveBalance(uint32_t slot)
+{
+    while (slot != none)
+    {
+        unsigned char height = cold[slot].height;
+        FixHeight(slot);
+        int balance = BalanceFactor(slot);
+        if (balance == 2)
+        {
+            if (BalanceFactor(hot[slot].left) >= 0)
+            {
+                RotateRight(slot);
+            }
+            else
+            {
+                RotateLeftRight(slot);
+            }
+            slot = cold[slot].parent;
+        }
+        else if (balance == -2)
+        {
+            if (BalanceFactor(hot[slot].right) <= 0)
+            {
+                RotateLeft(slot);
+            }
+            else
+            {
+                RotateRightLeft(slot);
+            }
+            slot = cold[slot].parent;
+        }
+        // subtree height didn't change, upper nodes are balanced
+        if (cold[slot].height == height)
+        {
+            break;
+        }
+        slot = cold[slot].parent;
+    }
+}
+
+// reads only the hot array
+uint32_t AVLTreeHotCold::FindSlot(int key)
+{
+    uint32_t slot = root;
+    while (slot != none)
+    {
+        const HotNode& node = hot[slot];
+        if (node.key == key)
+        {
+            return slot;
+        }
+        slot = key < node.key ? node.left : node.right;
+    }
+    return none;
+}
+
+uint32_t AVLTreeHotCold::FindMin(uint32_t slot)
+{
+    while (hot[slot].left != none)
+    {
+        slot = hot[slot].left;
+    }
+    return slot;
+}
+
+void AVLTreeHotCold::GetVector(uint32_t slot, std::vector<int>& vec)
+{
+    if (slot == none)
+    {
+        return;
+    }
+    GetVector(hot[slot].left, vec);
+    vec.push_back(hot[slot].key);
+    GetVector(hot[slot].right, vec);
+}
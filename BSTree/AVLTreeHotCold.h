@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// AVL tree with node fields split by use. Key and child links live in a dense
+// hot array that searches walk; parent and height live in a cold array at the
+// same slot and are touched only while inserting and removing. Links are
+// 32-bit slots, so a search reads 12 bytes per node instead of 40.
+class AVLTreeHotCold
+{
+public:
+    AVLTreeHotCold();
+
+    void Insert(int key);
+    void Remove(int key);
+    bool Find(int key);
+    size_t Height();
+    void Clear();
+    std::vector<int> GetVector();
+    size_t MemoryUsage();
+
+private:
+
+    static const uint32_t none = UINT32_MAX;
+
+    struct HotNode
+    {
+        int key;
+        uint32_t left;
+        uint32_t right;
+    };
+
+    struct ColdNode
+    {
+        uint32_t parent;
+        unsigned char height;
+    };
+
+    uint32_t NewSlot(int key);
+    void FreeSlot(uint32_t slot);
+    unsigned char Height(uint32_t slot);
+    void FixHeight(uint32_t slot);
+    int BalanceFactor(uint32_t slot);
+    void RotateLeft(uint32_t p);
+    void RotateRight(uint32_t p);
+    void RotateRightLeft(uint32_t p);
+    void RotateLeftRight(uint32_t p);
+    void InsertBalance(uint32_t slot);
+    void RemoveBalance(uint32_t slot);
+    uint32_t FindSlot(int key);
+    uint32_t FindMin(uint32_t slot);
+    void GetVector(uint32_t slot, std::vector<int>& vec);
+
+    std::vector<HotNode> hot;
+    std::vector<ColdNode> cold;
+    uint32_t root;
+    // free slots, linked through left of their hot nodes
+    uint32_t freeSlots;
+    size_t size;
+};
@@ -1,405 +1,838 @@
-#include "AVLTreeIterative.h"
-#include <algorithm>
-#include <cassert>
-
-AVLTreeIterative::Node::Node(int key) :
-    key{ key },
-    left{ nullptr },
-    right{ nullptr },
-    parent{ nullptr },
-    height{ 1 }
-{
-}
-
-AVLTreeIterative::Node::~Node()
-{
-    delete left;
-    delete right;
-}
-
-AVLTreeIterative::AVLTreeIterative() :
-    root { nullptr }
-{
-}
-
-AVLTreeIterative::~AVLTreeIterative()
-{
-    delete root;
-}
-
-void AVLTreeIterative::Insert(int key)
-{
-    InsertNode(key);
-}
-
-void AVLTreeIterative::Remove(int key)
-{
-    RemoveNode(key);
-}
-
-bool AVLTreeIterative::Find(int key)
-{
-    return FindNode(key) != nullptr;
-}
-
-void AVLTreeIterative::Clear()
-{
-    delete root;
-    root = nullptr;
-}
-
-std::vector<int> AVLTreeIterative::GetVector()
-{
-    std::vector<int> vec;
-    GetVector(root, vec);
-    return vec;
-}
-
-unsigned char AVLTreeIterative::Height(Node* node)
-{
-    if (node == nullptr)
-    {
-        return 0;
-    }
-    return node->height;
-}
-
-void AVLTreeIterative::FixHeight(Node* node)
-{
-    node->height = std::max(Height(node->left), Height(node->right)) + 1;
-}
-
-int AVLTreeIterative::BalanceFactor(Node* node)
-{
-    return Height(node->left) - Height(node->right);
-}
-
-void AVLTreeIterative::RotateLeft(Node* p)
-{
-    assert(p != nullptr);
-    assert(p->right != nullptr);
-    assert(root->parent == nullptr);
-
-    Node* q = p->right;
-
-    // p - c link
-    p->right = q->left;
-    if (p->right != nullptr)
-    {
-        p->right->parent = p;
-    }
-    // q - parent link
-    q->parent = p->parent;
-    if (q->parent == nullptr)
-    {
-        root = q;
-        assert(root->parent == nullptr);
-    }
-    else
-    {
-        if (p == p->parent->left)
-        {
-            q->parent->left = q;
-        }
-        else
-        {
-            q->parent->right = q;
-        }
-    }
-    // p - q link
-    q->left = p;
-    p->parent = q;
-
-    FixHeight(p);
-    FixHeight(q);
-}
-
-void AVLTreeIterative::RotateRight(Node* p)
-{
-    assert(p != nullptr);
-    assert(p->left != nullptr);
-    assert(root->parent == nullptr);
-
-    Node* q = p->left;
-
-    // p - c link
-    p->left = q->right;
-    if (p->left != nullptr)
-    {
-        p->left->parent = p;
-    }
-    // q - parent link
-    q->parent = p->parent;
-    if (q->parent == nullptr)
-    {
-        root = q;
-        assert(root->parent == nullptr);
-    }
-    else
-    {
-        if (p == p->parent->left)
-        {
-            q->parent->left = q;
-        }
-        else
-        {
-            q->parent->right = q;
-        }
-    }
-    // p - q link
-    q->right = p;
-    p->parent = q;
-
-    FixHeight(p);
-    FixHeight(q);
-}
-
-void AVLTreeIterative::RotateRightLeft(Node* p)
-{
-    RotateRight(p->right);
-    RotateLeft(p);
-}
-
-void AVLTreeIterative::RotateLeftRight(Node* p)
-{
-    RotateLeft(p->left);
-    RotateRight(p);
-}
-
-void AVLTreeIterative::InsertBalance(Node* node)
-{
-    while (node != nullptr)
-    {
-        FixHeight(node);
-        int balance = BalanceFactor(node);
-        if (balance == 0)
-        {
-            break;
-        }
-        if (balance == 2)
-        {
-            if (BalanceFactor(node->left) > 0)
-            {
-                RotateRight(node);
-            }
-            else
-            {
-                RotateLeftRight(node);
-            }
-            break;
-        }
-        if (balance == -2)
-        {
-            if (BalanceFactor(node->right) < 0)
-            {
-                RotateLeft(node);
-            }
-            else
-            {
-                RotateRightLeft(node);
-            }
-            break;
-        }
-        node = node->parent;
-    }
-}
-
-void AVLTreeIterative::RemoveBalance(Node* node)
-{
-    while (node != nullptr)
-    {
-        int balance = BalanceFactor(node);
-        if (balance == 0)
-        {
-            break;
-        }
-        FixHeight(node);
-        if (balance == 2)
-        {
-            if (BalanceFactor(node->left) > 0)
-            {
-                RotateRight(node);
-                node = node->parent;
-            }
-            else if (BalanceFactor(node->left) == 0)
-            {
-                RotateRight(node);
-                break;
-            }
-            else
-            {
-                RotateLeftRight(node);
-                node = node->parent;
-            }
-        }
-        if (balance == -2)
-        {
-            if (BalanceFactor(node->right) < 0)
-            {
-                RotateLeft(node);
-                node = node->parent;
-            }
-            else if (BalanceFactor(node->right) == 0)
-            {
-                RotateLeft(node);
-                break;
-            }
-            else
-            {
-                RotateRightLeft(node);
-                node = node->parent;
-            }
-        }
-        node = node->parent;
-    }
-}
-
-AVLTreeIterative::Node* AVLTreeIterative::FindNode(int key)
-{
-    Node* node = root;
-    while (node != nullptr)
-    {
-        if (node->key == key)
-        {
-            return node;
-        }
-        if (key < node->key)
-        {
-            node = node->left;
-        }
-        else
-        {
-            node = node->right;
-        }
-    }
-    return nullptr;
-}
-
-AVLTreeIterative::Node* AVLTreeIterative::FindMin(Node* node)
-{
-    while (node->left != nullptr)
-    {
-        node = node->left;
-    }
-    return node;
-}
-
-void AVLTreeIterative::InsertNode(int key)
-{
-    if (root == nullptr)
-    {
-        root = new Node(key);
-        return;
-    }
-
-    Node* parent = nullptr;
-    Node* node = root;
-    // go down and find insertion position
-    while (node != nullptr)
-    {
-        if (key == node->key)
-        {
-            return;
-        }
-
-        parent = node;
-        if (key < node->key)
-        {
-            node = node->left;
-        }
-        else
-        {
-            node = node->right;
-        }
-    }
-
-    // insert new node
-    node = new Node(key);
-    node->parent = parent;
-    if (key < parent->key)
-    {
-        parent->left = node;
-    }
-    else
-    {
-        parent->right = node;
-    }
-
-    // go up and balance tree
-    InsertBalance(parent);
-}
-
-void AVLTreeIterative::RemoveNode(int key)
-{
-    // find removing node
-    Node* node = FindNode(key);
-    if (node == nullptr)
-    {
-        return;
-    }
-
-    Node* y = node;
-    Node* x = nullptr;
-    // find y and its child x nodes
-    if (node->left == nullptr)
-    {
-        x = node->right;
-    }
-    else if (node->right == nullptr)
-    {
-        x = node->left;
-    }
-    else
-    {
-        y = FindMin(node->right);
-        x = y->right;
-    }
-    // exclude y
-    if (x != nullptr)
-    {
-        x->parent = y->parent;
-    }
-    if (y->parent == nullptr)
-    {
-        root = x;
-    }
-    else
-    {
-        if (y == y->parent->left)
-        {
-            y->parent->left = x;
-        }
-        else
-        {
-            y->parent->right = x;
-        }
-    }
-    if (y != node)
-    {
-        node->key = y->key;
-    }
-    
-    // go up and balance tree
-    RemoveBalance(y->parent);
-
-    // delete y
-    y->left = nullptr;
-    y->right = nullptr;
-    delete y;
-}
-
-void AVLTreeIterative::GetVector(Node* node, std::vector<int>& vec)
-{
-    if (node == nullptr)
-    {
-        return;
-    }
-    GetVector(node->left, vec);
-    vec.push_back(node->key);
-    GetVector(node->right, vec);
-}
-
-size_t AVLTreeIterative::Height()
-{
-	return Height(root);
-}
\ No newline at end of file
+#include "AVLTreeIterative.h"
+#include "Prefetch.h"
+#include "ParallelSort.h"
+#include <algorithm>
+#include <cassert>
+#include <new>
+#include <thread>
+
+AVLTreeIterative::AVLTreeIterative(bool multiset, bool hugePages) :
+    finger{ nullptr },
+    multiset{ multiset },
+    block{ nullptr },
+    blockSize{ 0 },
+    blockLive{ 0 },
+    allocator{ hugePages ? new HugePageAllocator(sizeof(Node)) : nullptr }
+{
+}
+
+AVLTreeIterative::~AVLTreeIterative()
+{
+    DeleteNodesRecursively(root);
+}
+
+AVLTreeIterative::Node* AVLTreeIterative::NewNode(int key)
+{
+    Node* node = allocator != nullptr ? new (allocator->Allocate()) Node : new Node;
+    node->key = key;
+    node->count = 1;
+    node->left = nullptr;
+    node->right = nullptr;
+    node->parent = nullptr;
+    node->height = 1;
+    return node;
+}
+
+void AVLTreeIterative::DeleteNode(Node* node)
+{
+    if (node == finger)
+    {
+        finger = nullptr;
+    }
+    if (!InBlock(node))
+    {
+        if (allocator != nullptr)
+        {
+            allocator->Free(node);
+        }
+        else
+        {
+            delete node;
+        }
+        return;
+    }
+    // nodes of the block are not freed one by one
+    blockLive--;
+    if (blockLive == 0)
+    {
+        if (allocator != nullptr)
+        {
+            allocator->FreeBlock(block);
+        }
+        else
+        {
+            ::operator delete(block);
+        }
+        block = nullptr;
+        blockSize = 0;
+    }
+}
+
+void AVLTreeIterative::DeleteNodesRecursively(Node* node)
+{
+    if (node == nullptr)
+    {
+        return;
+    }
+    DeleteNodesRecursively(node->left);
+    DeleteNodesRecursively(node->right);
+    DeleteNode(node);
+}
+
+void AVLTreeIterative::Insert(int key)
+{
+    InsertNode(root, key, 1);
+}
+
+void AVLTreeIterative::Insert(int key, unsigned int count)
+{
+    if (count > 0)
+    {
+        InsertNode(root, key, count);
+    }
+}
+
+void AVLTreeIterative::Remove(int key)
+{
+    RemoveNode(key, 1);
+}
+
+void AVLTreeIterative::Remove(int key, unsigned int count)
+{
+    if (count > 0)
+    {
+        RemoveNode(key, count);
+    }
+}
+
+unsigned int AVLTreeIterative::Count(int key)
+{
+    Node* node = FindNode(root, key);
+    if (node == nullptr)
+    {
+        return 0;
+    }
+    return node->count;
+}
+
+bool AVLTreeIterative::Floor(int key, int& result)
+{
+    Node* node = FloorNode(root, key, true);
+    if (node == nullptr)
+    {
+        return false;
+    }
+    result = node->key;
+    return true;
+}
+
+bool AVLTreeIterative::Ceiling(int key, int& result)
+{
+    Node* node = CeilingNode(root, key, true);
+    if (node == nullptr)
+    {
+        return false;
+    }
+    result = node->key;
+    return true;
+}
+
+bool AVLTreeIterative::Predecessor(int key, int& result)
+{
+    Node* node = FloorNode(root, key, false);
+    if (node == nullptr)
+    {
+        return false;
+    }
+    result = node->key;
+    return true;
+}
+
+bool AVLTreeIterative::Successor(int key, int& result)
+{
+    Node* node = CeilingNode(root, key, false);
+    if (node == nullptr)
+    {
+        return false;
+    }
+    result = node->key;
+    return true;
+}
+
+void AVLTreeIterative::Floor(const std::vector<int>& probes, std::vector<int>& results, std::vector<bool>& found)
+{
+    results.resize(probes.size());
+    found.resize(probes.size());
+    Node* finger = nullptr;
+    for (size_t i = 0; i < probes.size(); i++)
+    {
+        assert(i == 0 || probes[i - 1] <= probes[i]);
+        finger = finger == nullptr ? FloorNode(root, probes[i], true) : FloorNear(finger, probes[i]);
+        found[i] = finger != nullptr;
+        if (finger != nullptr)
+        {
+            results[i] = finger->key;
+        }
+    }
+}
+
+void AVLTreeIterative::Ceiling(const std::vector<int>& probes, std::vector<int>& results, std::vector<bool>& found)
+{
+    results.resize(probes.size());
+    found.resize(probes.size());
+    Node* finger = nullptr;
+    for (size_t i = 0; i < probes.size(); i++)
+    {
+        assert(i == 0 || probes[i - 1] <= probes[i]);
+        finger = i == 0 ? CeilingNode(root, probes[i], true) : CeilingNear(finger, probes[i]);
+        found[i] = finger != nullptr;
+        if (finger != nullptr)
+        {
+            results[i] = finger->key;
+        }
+    }
+}
+
+// finger is floor of a smaller key, so floor of key is finger or lies to the right of it
+AVLTreeIterative::Node* AVLTreeIterative::FloorNear(Node* finger, int key)
+{
+    // go up while parent is not greater than key, then floor is in subtree of node
+    Node* node = finger;
+    while (node->parent != nullptr && node->parent->key <= key)
+    {
+        node = node->parent;
+    }
+    return FloorNode(node, key, true);
+}
+
+// finger is ceiling of a smaller key, nil if that key is greater than all keys
+AVLTreeIterative::Node* AVLTreeIterative::CeilingNear(Node* finger, int key)
+{
+    if (finger == nullptr || finger->key >= key)
+    {
+        return finger;
+    }
+    // go up while parent is less than key, then ceiling is parent or in subtree of node
+    Node* node = finger;
+    while (node->parent != nullptr && node->parent->key < key)
+    {
+        node = node->parent;
+    }
+    Node* best = CeilingNode(node, key, true);
+    return best != nullptr ? best : node->parent;
+}
+
+bool AVLTreeIterative::Find(int key)
+{
+    return FindNode(root, key) != nullptr;
+}
+
+void AVLTreeIterative::InsertNear(int key)
+{
+    finger = InsertNode(StartNear(finger, key), key, 1);
+}
+
+bool AVLTreeIterative::FindNear(int key)
+{
+    Node* node = FindNode(StartNear(finger, key), key);
+    if (node == nullptr)
+    {
+        return false;
+    }
+    finger = node;
+    return true;
+}
+
+AVLTreeIterative::Node* AVLTreeIterative::StartNear(Node* finger, int key)
+{
+    if (finger == nullptr || finger->key == key)
+    {
+        return finger == nullptr ? root : finger;
+    }
+    // climb while parent is not beyond key; a parent reached from the side of key bounds nothing
+    // new, so the search restarts only at parents reached from the other side
+    Node* start = finger;
+    Node* node = finger;
+    if (key > finger->key)
+    {
+        while (node->parent != nullptr && node->parent->key <= key)
+        {
+            start = node == node->parent->left ? node->parent : start;
+            node = node->parent;
+        }
+    }
+    else
+    {
+        while (node->parent != nullptr && node->parent->key >= key)
+        {
+            start = node == node->parent->right ? node->parent : start;
+            node = node->parent;
+        }
+    }
+    return start;
+}
+
+void AVLTreeIterative::FindBatch(const std::vector<int>& keys, std::vector<bool>& found)
+{
+    FindInterleaved(root, nullptr, keys, found);
+}
+
+void AVLTreeIterative::RemoveRange(int lo, int hi)
+{
+    DeleteNodesRecursively(CutRange(lo, hi));
+}
+
+void AVLTreeIterative::ExtractRange(int lo, int hi, AVLTreeIterative& out)
+{
+    // finger may move to out
+    finger = nullptr;
+    out.Clear();
+    Node* middle = CutRange(lo, hi);
+    if (block != nullptr || allocator != nullptr || out.allocator != nullptr)
+    {
+        middle = Relocate(middle, out);
+    }
+    out.root = middle;
+}
+
+void AVLTreeIterative::Compact()
+{
+    if (root == nullptr)
+    {
+        return;
+    }
+    finger = nullptr;
+    std::vector<Node*> order;
+    order.reserve(Size(root));
+    VebOrder(root, Height(root), order);
+
+    // copy nodes in order, every old node keeps address of its copy in parent
+    Node* newBlock = static_cast<Node*>(allocator != nullptr ? allocator->AllocateBlock(order.size()) : ::operator new(order.size() * sizeof(Node)));
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        new (newBlock + i) Node(*order[i]);
+        order[i]->parent = newBlock + i;
+    }
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        Node* node = newBlock + i;
+        if (node->left != nullptr)
+        {
+            node->left = node->left->parent;
+        }
+        if (node->right != nullptr)
+        {
+            node->right = node->right->parent;
+        }
+        if (node->parent != nullptr)
+        {
+            node->parent = node->parent->parent;
+        }
+    }
+    root = root->parent;
+
+    // frees previous block with its last node
+    for (Node* node : order)
+    {
+        DeleteNode(node);
+    }
+    block = newBlock;
+    blockSize = order.size();
+    blockLive = order.size();
+}
+
+void AVLTreeIterative::Clear()
+{
+    DeleteNodesRecursively(root);
+    root = nullptr;
+}
+
+std::vector<int> AVLTreeIterative::GetVector()
+{
+    std::vector<int> vec;
+    GetVector(root, vec);
+    return vec;
+}
+
+void AVLTreeIterative::JoinBalance(Node* node)
+{
+    // joined subtree may be taller by 1 or 2 levels, go up to the top
+    while (node != nullptr)
+    {
+        FixHeight(node);
+        int balance = BalanceFactor(node);
+        if (balance == 2)
+        {
+            if (BalanceFactor(node->left) >= 0)
+            {
+                RotateRight(node);
+            }
+            else
+            {
+                RotateLeftRight(node);
+            }
+        }
+        if (balance == -2)
+        {
+            if (BalanceFactor(node->right) <= 0)
+            {
+                RotateLeft(node);
+            }
+            else
+            {
+                RotateRightLeft(node);
+            }
+        }
+        node = node->parent;
+    }
+}
+
+AVLTreeIterative::Node* AVLTreeIterative::FindNode(Node* start, int key)
+{
+    Node* node = start;
+    while (node != nullptr)
+    {
+        if (node->key == key)
+        {
+            return node;
+        }
+        if (key < node->key)
+        {
+            node = node->left;
+        }
+        else
+        {
+            node = node->right;
+        }
+    }
+    return nullptr;
+}
+
+void AVLTreeIterative::BuildParallel(const int* keys, size_t n, unsigned int threads)
+{
+    threads = BuildThreads(threads);
+    std::vector<int> sorted(keys, keys + n);
+    ParallelSort(sorted, threads);
+    std::vector<unsigned int> counts;
+    if (multiset)
+    {
+        CountRuns(sorted, counts);
+    }
+    else
+    {
+        sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    }
+
+    Clear();
+    // the node allocator is not thread safe, so with huge pages one thread builds the tree
+    if (allocator != nullptr)
+    {
+        threads = 1;
+    }
+    root = Build(sorted.data(), counts.empty() ? nullptr : counts.data(), sorted.size(), threads);
+}
+
+// balanced subtree of n sorted keys, halves differ in size by at most one so heights differ by at most one;
+// left halves go to other threads while there are threads to spare
+AVLTreeIterative::Node* AVLTreeIterative::Build(const int* keys, const unsigned int* counts, size_t n, unsigned int threads)
+{
+    if (n == 0)
+    {
+        return nullptr;
+    }
+    size_t middle = n / 2;
+    Node* node = NewNode(keys[middle]);
+    node->count = counts != nullptr ? counts[middle] : 1;
+    const unsigned int* rightCounts = counts != nullptr ? counts + middle + 1 : nullptr;
+    if (threads > 1 && n > 4096)
+    {
+        std::thread worker([&]() { node->left = Build(keys, counts, middle, threads / 2); });
+        node->right = Build(keys + middle + 1, rightCounts, n - middle - 1, threads - threads / 2);
+        worker.join();
+    }
+    else
+    {
+        node->left = Build(keys, counts, middle, 1);
+        node->right = Build(keys + middle + 1, rightCounts, n - middle - 1, 1);
+    }
+    if (node->left != nullptr)
+    {
+        node->left->parent = node;
+    }
+    if (node->right != nullptr)
+    {
+        node->right->parent = node;
+    }
+    FixHeight(node);
+    return node;
+}
+
+AVLTreeIterative::Node* AVLTreeIterative::InsertNode(Node* start, int key, unsigned int count)
+{
+    Node* parent = nullptr;
+    Node* node = start;
+    // go down and find insertion position
+    while (node != nullptr)
+    {
+        if (key == node->key)
+        {
+            // existing key, no structural changes
+            if (multiset)
+            {
+                node->count += count;
+            }
+            return node;
+        }
+
+        parent = node;
+        if (key < node->key)
+        {
+            node = node->left;
+        }
+        else
+        {
+            node = node->right;
+        }
+    }
+
+    // insert new node
+    node = NewNode(key);
+    node->count = multiset ? count : 1;
+    InsertLeaf(node, parent, parent != nullptr && key < parent->key);
+    return node;
+}
+
+void AVLTreeIterative::RemoveNode(int key, unsigned int count)
+{
+    // find removing node
+    Node* node = FindNode(root, key);
+    if (node == nullptr)
+    {
+        return;
+    }
+    // other occurrences left, no structural changes
+    if (node->count > count)
+    {
+        node->count -= count;
+        return;
+    }
+
+    Node* y = Unlink(node);
+    // delete y
+    y->left = nullptr;
+    y->right = nullptr;
+    DeleteNode(y);
+}
+
+AVLTreeIterative::Node* AVLTreeIterative::FloorNode(Node* node, int key, bool inclusive)
+{
+    Node* best = nullptr;
+    while (node != nullptr)
+    {
+        if (node->key < key || (inclusive && node->key == key))
+        {
+            best = node;
+            node = node->right;
+        }
+        else
+        {
+            node = node->left;
+        }
+    }
+    return best;
+}
+
+AVLTreeIterative::Node* AVLTreeIterative::CeilingNode(Node* node, int key, bool inclusive)
+{
+    Node* best = nullptr;
+    while (node != nullptr)
+    {
+        if (node->key > key || (inclusive && node->key == key))
+        {
+            best = node;
+            node = node->left;
+        }
+        else
+        {
+            node = node->right;
+        }
+    }
+    return best;
+}
+
+void AVLTreeIterative::GetVector(Node* node, std::vector<int>& vec)
+{
+    if (node == nullptr)
+    {
+        return;
+    }
+    GetVector(node->left, vec);
+    vec.push_back(node->key);
+    GetVector(node->right, vec);
+}
+
+bool AVLTreeIterative::InBlock(Node* node)
+{
+    return block != nullptr && node >= block && node < block + blockSize;
+}
+
+// copy nodes of subtree that to can't free as they are into memory of to, so the subtree can go there
+AVLTreeIterative::Node* AVLTreeIterative::Relocate(Node* node, AVLTreeIterative& to)
+{
+    if (node == nullptr)
+    {
+        return nullptr;
+    }
+    node->left = Relocate(node->left, to);
+    node->right = Relocate(node->right, to);
+    if (InBlock(node) || allocator != nullptr || to.allocator != nullptr)
+    {
+        Node* copy = to.NewNode(node->key);
+        *copy = *node;
+        DeleteNode(node);
+        node = copy;
+    }
+    if (node->left != nullptr)
+    {
+        node->left->parent = node;
+    }
+    if (node->right != nullptr)
+    {
+        node->right->parent = node;
+    }
+    return node;
+}
+
+// van Emde Boas order of the top height levels of subtree: the upper half of the levels,
+// then every subtree hanging below them, each laid out the same way
+void AVLTreeIterative::VebOrder(Node* node, size_t height, std::vector<Node*>& order)
+{
+    if (node == nullptr || height == 0)
+    {
+        return;
+    }
+    if (height == 1)
+    {
+        order.push_back(node);
+        return;
+    }
+    size_t topHeight = height / 2;
+    VebOrder(node, topHeight, order);
+    std::vector<Node*> bottoms;
+    CollectAtDepth(node, topHeight, bottoms);
+    for (Node* bottom : bottoms)
+    {
+        VebOrder(bottom, height - topHeight, order);
+    }
+}
+
+void AVLTreeIterative::CollectAtDepth(Node* node, size_t depth, std::vector<Node*>& nodes)
+{
+    if (node == nullptr)
+    {
+        return;
+    }
+    if (depth == 0)
+    {
+        nodes.push_back(node);
+        return;
+    }
+    CollectAtDepth(node->left, depth - 1, nodes);
+    CollectAtDepth(node->right, depth - 1, nodes);
+}
+
+size_t AVLTreeIterative::Height()
+{
+	return Height(root);
+}
+
+size_t AVLTreeIterative::MemoryUsage()
+{
+    return Size(root) * sizeof(Node);
+}
+
+size_t AVLTreeIterative::HugePageBytes()
+{
+    return allocator != nullptr ? allocator->HugePageBytes() : 0;
+}
+
+size_t AVLTreeIterative::RebalanceSteps()
+{
+    return rebalanceSteps;
+}
+
+size_t AVLTreeIterative::Size(Node* node)
+{
+    if (node == nullptr)
+    {
+        return 0;
+    }
+    return Size(node->left) + Size(node->right) + 1;
+}
+
+// Join and Split work on detached subtrees (parent == nullptr).
+// Rotations at the top of a subtree update root, so Join uses root
+// as the top of the subtree being rebalanced.
+AVLTreeIterative::Node* AVLTreeIterative::Join(Node* left, Node* middle, Node* right)
+{
+    int leftHeight = Height(left);
+    int rightHeight = Height(right);
+
+    if (leftHeight > rightHeight + 1)
+    {
+        // go down the right spine of left to a subtree of right's height
+        root = left;
+        Node* node = left;
+        while (Height(node->right) > rightHeight + 1)
+        {
+            node = node->right;
+        }
+        middle->left = node->right;
+        if (middle->left != nullptr)
+        {
+            middle->left->parent = middle;
+        }
+        middle->right = right;
+        if (right != nullptr)
+        {
+            right->parent = middle;
+        }
+        FixHeight(middle);
+        node->right = middle;
+        middle->parent = node;
+        JoinBalance(node);
+        return root;
+    }
+
+    if (rightHeight > leftHeight + 1)
+    {
+        // go down the left spine of right to a subtree of left's height
+        root = right;
+        Node* node = right;
+        while (Height(node->left) > leftHeight + 1)
+        {
+            node = node->left;
+        }
+        middle->right = node->left;
+        if (middle->right != nullptr)
+        {
+            middle->right->parent = middle;
+        }
+        middle->left = left;
+        if (left != nullptr)
+        {
+            left->parent = middle;
+        }
+        FixHeight(middle);
+        node->left = middle;
+        middle->parent = node;
+        JoinBalance(node);
+        return root;
+    }
+
+    middle->left = left;
+    middle->right = right;
+    middle->parent = nullptr;
+    if (left != nullptr)
+    {
+        left->parent = middle;
+    }
+    if (right != nullptr)
+    {
+        right->parent = middle;
+    }
+    FixHeight(middle);
+    return middle;
+}
+
+AVLTreeIterative::Node* AVLTreeIterative::Join(Node* left, Node* right)
+{
+    if (left == nullptr)
+    {
+        return right;
+    }
+    if (right == nullptr)
+    {
+        return left;
+    }
+    Node* less;
+    Node* min;
+    Node* greater;
+    Split(right, FindMin(right)->key, less, min, greater);
+    return Join(left, min, greater);
+}
+
+// split node's subtree into keys less than key, node with key (or nullptr) and greater keys
+void AVLTreeIterative::Split(Node* node, int key, Node*& less, Node*& equal, Node*& greater)
+{
+    if (node == nullptr)
+    {
+        less = nullptr;
+        equal = nullptr;
+        greater = nullptr;
+        return;
+    }
+
+    // detach node from its children
+    Node* left = node->left;
+    Node* right = node->right;
+    if (left != nullptr)
+    {
+        left->parent = nullptr;
+    }
+    if (right != nullptr)
+    {
+        right->parent = nullptr;
+    }
+    node->left = nullptr;
+    node->right = nullptr;
+    node->parent = nullptr;
+    node->height = 1;
+
+    if (key == node->key)
+    {
+        less = left;
+        equal = node;
+        greater = right;
+    }
+    else if (key < node->key)
+    {
+        Node* lessGreater;
+        Split(left, key, less, equal, lessGreater);
+        greater = Join(lessGreater, node, right);
+    }
+    else
+    {
+        Node* greaterLess;
+        Split(right, key, greaterLess, equal, greater);
+        less = Join(left, node, greaterLess);
+    }
+}
+
+// detach subtree with keys in [lo, hi], the rest is joined back with one pass per split level
+AVLTreeIterative::Node* AVLTreeIterative::CutRange(int lo, int hi)
+{
+    if (root == nullptr || lo > hi)
+    {
+        return nullptr;
+    }
+
+    Node* less;
+    Node* loNode;
+    Node* rest;
+    Node* middle;
+    Node* hiNode;
+    Node* greater;
+    Split(root, lo, less, loNode, rest);
+    Split(rest, hi, middle, hiNode, greater);
+    if (loNode != nullptr)
+    {
+        middle = Join(nullptr, loNode, middle);
+    }
+    if (hiNode != nullptr)
+    {
+        middle = Join(middle, hiNode, nullptr);
+    }
+    root = Join(less, greater);
+    return middle;
+}
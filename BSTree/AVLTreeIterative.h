@@ -1,50 +1,108 @@
-#pragma once
-
-#include <vector>
-
-class AVLTreeIterative
-{
-public:
-	AVLTreeIterative();
-	~AVLTreeIterative();
-
-    void Insert(int key);
-    void Remove(int key);
-    bool Find(int key);
-    void Clear();
-    std::vector<int> GetVector();
-	size_t Height();
-
-private:
-
-    struct Node
-    {
-        int key;
-        Node* left;
-        Node* right;
-        Node* parent;
-        unsigned char height;
-
-        Node(int key);
-        ~Node();
-    };
-
-    unsigned char Height(Node* node);
-    void FixHeight(Node* node);
-    int BalanceFactor(Node* node);
-
-    void RotateLeft(Node* p);
-    void RotateRight(Node* p);
-    void RotateRightLeft(Node* p);
-    void RotateLeftRight(Node* p);
-    void InsertBalance(Node* node);
-    void RemoveBalance(Node* node);
-    Node* FindNode(int key);
-    Node* FindMin(Node* node);
-    void InsertNode(int key);
-    void RemoveNode(int key);
-    void GetVector(Node* node, std::vector<int>& vec);
-
-    Node* root;
-};
-
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "AVLTreeBase.h"
+#include "HugePageAllocator.h"
+
+// key of an AVLTreeIterative node and its number of occurrences
+struct AVLTreeIterativeEntry
+{
+    int key;
+    unsigned int count;
+};
+
+class AVLTreeIterative : private AVLTreeBase<AVLTreeIterativeEntry>
+{
+public:
+	// in multiset mode every key keeps count of its occurrences,
+	// with hugePages nodes are allocated from 2 MB regions backed by huge pages where possible
+	AVLTreeIterative(bool multiset = false, bool hugePages = false);
+	~AVLTreeIterative();
+
+    void Insert(int key);
+    // add count occurrences of key, in set mode key is stored once
+    void Insert(int key, unsigned int count);
+    void Remove(int key);
+    // remove up to count occurrences of key
+    void Remove(int key, unsigned int count);
+    // replace content with keys: they are sorted, deduplicated and built into a balanced tree,
+    // subtrees are built by threads in parallel; threads 0 means one per hardware thread
+    void BuildParallel(const int* keys, size_t n, unsigned int threads = 0);
+    bool Find(int key);
+    // Insert and Find starting at the node of the previous InsertNear/FindNear: the search goes up
+    // from it until key is in the subtree, then down, so keys d apart cost O(log d) instead of O(log n)
+    void InsertNear(int key);
+    bool FindNear(int key);
+    // Find of every key, descents of a group of keys are interleaved so their cache misses overlap
+    void FindBatch(const std::vector<int>& keys, std::vector<bool>& found);
+    unsigned int Count(int key);
+    // largest key <= key, smallest key >= key, largest key < key, smallest key > key;
+    // return false if there is no such key
+    bool Floor(int key, int& result);
+    bool Ceiling(int key, int& result);
+    bool Predecessor(int key, int& result);
+    bool Successor(int key, int& result);
+    // Floor/Ceiling of every probe, probes are sorted; found[i] tells if results[i] is set
+    void Floor(const std::vector<int>& probes, std::vector<int>& results, std::vector<bool>& found);
+    void Ceiling(const std::vector<int>& probes, std::vector<int>& results, std::vector<bool>& found);
+    // remove all keys in [lo, hi]
+    void RemoveRange(int lo, int hi);
+    // move all keys in [lo, hi] to out, replacing its content
+    void ExtractRange(int lo, int hi, AVLTreeIterative& out);
+    // relocate all nodes into one new block in van Emde Boas order, so a lookup touches fewer
+    // cache lines and pages; nodes inserted later come from the heap until the next Compact
+    void Compact();
+    void Clear();
+    std::vector<int> GetVector();
+	size_t Height();
+    size_t MemoryUsage();
+    // bytes of node memory backed by huge pages, 0 without hugePages
+    size_t HugePageBytes();
+    // loop steps of insert and remove balancing so far, telling how far rebalancing went up
+    size_t RebalanceSteps();
+
+private:
+
+    // Height() hides it otherwise
+    using AVLTreeBase::Height;
+
+    Node* NewNode(int key);
+    void DeleteNode(Node* node);
+    void DeleteNodesRecursively(Node* node);
+
+    void JoinBalance(Node* node);
+    Node* FindNode(Node* start, int key);
+    // lowest ancestor of finger whose subtree would hold key
+    Node* StartNear(Node* finger, int key);
+    // returns the node holding key
+    Node* InsertNode(Node* start, int key, unsigned int count);
+    void RemoveNode(int key, unsigned int count);
+    Node* Build(const int* keys, const unsigned int* counts, size_t n, unsigned int threads);
+    Node* FloorNode(Node* node, int key, bool inclusive);
+    Node* CeilingNode(Node* node, int key, bool inclusive);
+    Node* FloorNear(Node* finger, int key);
+    Node* CeilingNear(Node* finger, int key);
+    Node* Join(Node* left, Node* middle, Node* right);
+    Node* Join(Node* left, Node* right);
+    void Split(Node* node, int key, Node*& less, Node*& equal, Node*& greater);
+    Node* CutRange(int lo, int hi);
+    bool InBlock(Node* node);
+    Node* Relocate(Node* node, AVLTreeIterative& to);
+    void VebOrder(Node* node, size_t height, std::vector<Node*>& order);
+    void CollectAtDepth(Node* node, size_t depth, std::vector<Node*>& nodes);
+    void GetVector(Node* node, std::vector<int>& vec);
+    size_t Size(Node* node);
+
+    // node of the last InsertNear/FindNear, nullptr once it is deleted or moved
+    Node* finger;
+    bool multiset;
+    // nodes placed by Compact, the block is freed when the last of them is deleted
+    Node* block;
+    size_t blockSize;
+    size_t blockLive;
+    // allocator of nodes with hugePages, otherwise new and delete
+    std::unique_ptr<HugePageAllocator> allocator;
+};
+
@@ -0,0 +1,783 @@
+#include "AdaptiveRadixTree.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ART_SSE2
+#endif
+
+AdaptiveRadixTree::Node::Node(NodeType type) :
+    type{ type },
+    prefixLength{ 0 },
+    count{ 0 },
+    prefix{}
+{
+}
+
+AdaptiveRadixTree::Node4::Node4() :
+    Node(NodeType::Node4),
+    keys{},
+    children{}
+{
+}
+
+AdaptiveRadixTree::Node16::Node16() :
+    Node(NodeType::Node16),
+    keys{},
+    children{}
+{
+}
+
+AdaptiveRadixTree::Node48::Node48() :
+    Node(NodeType::Node48),
+    index{},
+    children{}
+{
+}
+
+AdaptiveRadixTree::Node256::Node256() :
+    Node(NodeType::Node256),
+    children{}
+{
+}
+
+AdaptiveRadixTree::AdaptiveRadixTree() :
+    root{ 0 }
+{
+}
+
+AdaptiveRadixTree::~AdaptiveRadixTree()
+{
+    DeleteNodesRecursively(root);
+}
+
+void AdaptiveRadixTree::Insert(int key)
+{
+    Insert(root, ToRadix(key), 0);
+}
+
+void AdaptiveRadixTree::Remove(int key)
+{
+    uint32_t radixKey = ToRadix(key);
+    if (root == 0)
+    {
+        return;
+    }
+    if (IsLeaf(root))
+    {
+        if (LeafKey(root) == radixKey)
+        {
+            root = 0;
+        }
+        return;
+    }
+    Remove(root, radixKey, 0);
+}
+
+bool AdaptiveRadixTree::Find(int key)
+{
+    uint32_t radixKey = ToRadix(key);
+    Child child = root;
+    unsigned int depth = 0;
+    while (child != 0)
+    {
+        if (IsLeaf(child))
+        {
+            return LeafKey(child) == radixKey;
+        }
+        Node* node = ToNode(child);
+        // prefix is skipped without comparing, the leaf has the whole key
+        depth += node->prefixLength;
+        Child* next = FindChild(node, KeyByte(radixKey, depth));
+        if (next == nullptr)
+        {
+            return false;
+        }
+        child = *next;
+        depth++;
+    }
+    return false;
+}
+
+void AdaptiveRadixTree::Clear()
+{
+    DeleteNodesRecursively(root);
+    root = 0;
+}
+
+std::vector<int> AdaptiveRadixTree::GetVector()
+{
+    std::vector<int> vec;
+    GetVector(root, vec);
+    return vec;
+}
+
+size_t AdaptiveRadixTree::Height()
+{
+    return Height(root);
+}
+
+size_t AdaptiveRadixTree::MemoryUsage()
+{
+    return MemoryUsage(root);
+}
+
+bool AdaptiveRadixTree::IsLeaf(Child child)
+{
+    return (child & 1) != 0;
+}
+
+AdaptiveRadixTree::Child AdaptiveRadixTree::MakeLeaf(uint32_t key)
+{
+    return (static_cast<Child>(key) << 32) | 1;
+}
+
+uint32_t AdaptiveRadixTree::LeafKey(Child child)
+{
+    return static_cast<uint32_t>(child >> 32);
+}
+
+AdaptiveRadixTree::Node* AdaptiveRadixTree::ToNode(Child child)
+{
+    return reinterpret_cast<Node*>(static_cast<uintptr_t>(child));
+}
+
+AdaptiveRadixTree::Child AdaptiveRadixTree::FromNode(Node* node)
+{
+    return static_cast<Child>(reinterpret_cast<uintptr_t>(node));
+}
+
+// flipping the sign bit makes unsigned order of the result match int order
+uint32_t AdaptiveRadixTree::ToRadix(int key)
+{
+    return static_cast<uint32_t>(key) ^ 0x80000000u;
+}
+
+uint8_t AdaptiveRadixTree::KeyByte(uint32_t key, unsigned int depth)
+{
+    assert(depth < 4);
+    return static_cast<uint8_t>(key >> (24 - 8 * depth));
+}
+
+void AdaptiveRadixTree::CopyPrefix(Node* to, const Node* from)
+{
+    to->prefixLength = from->prefixLength;
+    std::memcpy(to->prefix, from->prefix, sizeof(from->prefix));
+}
+
+AdaptiveRadixTree::Child* AdaptiveRadixTree::FindChild(Node* node, uint8_t byte)
+{
+    switch (node->type)
+    {
+    case NodeType::Node4:
+    {
+        Node4* n = static_cast<Node4*>(node);
+        for (unsigned int i = 0; i < n->count; i++)
+        {
+            if (n->keys[i] == byte)
+            {
+                return &n->children[i];
+            }
+        }
+        return nullptr;
+    }
+    case NodeType::Node16:
+    {
+        Node16* n = static_cast<Node16*>(node);
+#ifdef ART_SSE2
+        // compare all 16 keys at once, bits past count are garbage
+        __m128i matches = _mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(byte)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(n->keys)));
+        unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(matches)) & ((1u << n->count) - 1);
+        for (unsigned int i = 0; i < 16; i++)
+        {
+            if (mask & (1u << i))
+            {
+                return &n->children[i];
+            }
+        }
+#else
+        for (unsigned int i = 0; i < n->count; i++)
+        {
+            if (n->keys[i] == byte)
+            {
+                return &n->children[i];
+            }
+        }
+#endif
+        return nullptr;
+    }
+    case NodeType::Node48:
+    {
+        Node48* n = static_cast<Node48*>(node);
+        if (n->index[byte] == 0)
+        {
+            return nullptr;
+        }
+        return &n->children[n->index[byte] - 1];
+    }
+    case NodeType::Node256:
+    {
+        Node256* n = static_cast<Node256*>(node);
+        if (n->children[byte] == 0)
+        {
+            return nullptr;
+        }
+        return &n->children[byte];
+    }
+    }
+    return nullptr;
+}
+
+void AdaptiveRadixTree::AddChild(Child& ref, Node* node, uint8_t byte, Child child)
+{
+    switch (node->type)
+    {
+    case NodeType::Node4:
+    {
+        Node4* n = static_cast<Node4*>(node);
+        if (n->count < 4)
+        {
+            unsigned int position = 0;
+            while (position < n->count && n->keys[position] < byte)
+            {
+                position++;
+            }
+            std::memmove(n->keys + position + 1, n->keys + position, n->count - position);
+            std::memmove(n->children + position + 1, n->children + position, (n->count - position) * sizeof(Child));
+            n->keys[position] = byte;
+            n->children[position] = child;
+            n->count++;
+            return;
+        }
+        Node16* grown = new Node16();
+        CopyPrefix(grown, n);
+        grown->count = n->count;
+        std::memcpy(grown->keys, n->keys, n->count);
+        std::memcpy(grown->children, n->children, n->count * sizeof(Child));
+        delete n;
+        ref = FromNode(grown);
+        AddChild(ref, grown, byte, child);
+        return;
+    }
+    case NodeType::Node16:
+    {
+        Node16* n = static_cast<Node16*>(node);
+        if (n->count < 16)
+        {
+            unsigned int position = 0;
+            while (position < n->count && n->keys[position] < byte)
+            {
+                position++;
+            }
+            std::memmove(n->keys + position + 1, n->keys + position, n->count - position);
+            std::memmove(n->children + position + 1, n->children + position, (n->count - position) * sizeof(Child));
+            n->keys[position] = byte;
+            n->children[position] = child;
+            n->count++;
+            return;
+        }
+        Node48* grown = new Node48();
+        CopyPrefix(grown, n);
+        grown->count = n->count;
+        for (unsigned int i = 0; i < n->count; i++)
+        {
+            grown->index[n->keys[i]] = static_cast<uint8_t>(i + 1);
+            grown->children[i] = n->children[i];
+        }
+        delete n;
+        ref = FromNode(grown);
+        AddChild(ref, grown, byte, child);
+        return;
+    }
+    case NodeType::Node48:
+    {
+        Node48* n = static_cast<Node48*>(node);
+        if (n->count < 48)
+        {
+            n->children[n->count] = child;
+            n->index[byte] = static_cast<uint8_t>(n->count + 1);
+            n->count++;
+            return;
+        }
+        Node256* grown = new Node256();
+        CopyPrefix(grown, n);
+        grown->count = n->count;
+        for (unsigned int b = 0; b < 256; b++)
+        {
+            if (n->index[b] != 0)
+            {
+                grown->children[b] = n->children[n->index[b] - 1];
+            }
+        }
+        delete n;
+        ref = FromNode(grown);
+        AddChild(ref, grown, byte, child);
+        return;
+    }
+    case NodeType::Node256:
+    {
+        Node256* n = static_cast<Node256*>(node);
+        n->children[byte] = child;
+        n->count++;
+        return;
+    }
+    }
+}
+
+// nodes shrink to the smaller type a few children below its capacity, so
+// alternating inserts and removes at the boundary don't convert every time
+void AdaptiveRadixTree::RemoveChild(Child& ref, Node* node, uint8_t byte)
+{
+    switch (node->type)
+    {
+    case NodeType::Node4:
+    {
+        Node4* n = static_cast<Node4*>(node);
+        unsigned int position = 0;
+        while (n->keys[position] != byte)
+        {
+            position++;
+        }
+        std::memmove(n->keys + position, n->keys + position + 1, n->count - position - 1);
+        std::memmove(n->children + position, n->children + position + 1, (n->count - position - 1) * sizeof(Child));
+        n->count--;
+        if (n->count > 1)
+        {
+            return;
+        }
+        // one child left, it replaces the node and takes over its prefix and byte
+        Child only = n->children[0];
+        if (!IsLeaf(only))
+        {
+            Node* child = ToNode(only);
+            uint8_t prefix[3];
+            unsigned int length = n->prefixLength;
+            std::memcpy(prefix, n->prefix, length);
+            prefix[length++] = n->keys[0];
+            std::memcpy(prefix + length, child->prefix, child->prefixLength);
+            length += child->prefixLength;
+            assert(length <= 3);
+            std::memcpy(child->prefix, prefix, length);
+            child->prefixLength = static_cast<uint8_t>(length);
+        }
+        delete n;
+        ref = only;
+        return;
+    }
+    case NodeType::Node16:
+    {
+        Node16* n = static_cast<Node16*>(node);
+        unsigned int position = 0;
+        while (n->keys[position] != byte)
+        {
+            position++;
+        }
+        std::memmove(n->keys + position, n->keys + position + 1, n->count - position - 1);
+        std::memmove(n->children + position, n->children + position + 1, (n->count - position - 1) * sizeof(Child));
+        n->count--;
+        if (n->count > 3)
+        {
+            return;
+        }
+        Node4* shrunk = new Node4();
+        CopyPrefix(shrunk, n);
+        shrunk->count = n->count;
+        std::memcpy(shrunk->keys, n->keys, n->count);
+        std::memcpy(shrunk->children, n->children, n->count * sizeof(Child));
+        delete n;
+        ref = FromNode(shrunk);
+        return;
+    }
+    case NodeType::Node48:
+    {
+        Node48* n = static_cast<Node48*>(node);
+        unsigned int slot = n->index[byte] - 1;
+        n->index[byte] = 0;
+        n->count--;
+        // last used slot fills the hole
+        if (slot != n->count)
+        {
+            for (unsigned int b = 0; b < 256; b++)
+            {
+                if (n->index[b] == n->count + 1)
+                {
+                    n->index[b] = static_cast<uint8_t>(slot + 1);
+                    break;
+                }
+            }
+            n->children[slot] = n->children[n->count];
+        }
+        n->children[n->count] = 0;
+        if (n->count > 12)
+        {
+            return;
+        }
+        Node16* shrunk = new Node16();
+        CopyPrefix(shrunk, n);
+        for (unsigned int b = 0; b < 256; b++)
+        {
+            if (n->index[b] != 0)
+            {
+                shrunk->keys[shrunk->count] = static_cast<uint8_t>(b);
+                shrunk->children[shrunk->count] = n->children[n->index[b] - 1];
+                shrunk->count++;
+            }
+        }
+        delete n;
+        ref = FromNode(shrunk);
+        return;
+    }
+    case NodeType::Node256:
+    {
+        Node256* n = static_cast<Node256*>(node);
+        n->children[byte] = 0;
+        n->count--;
+        if (n->count > 37)
+        {
+            return;
+        }
+        Node48* shrunk = new Node48();
+        CopyPrefix(shrunk, n);
+        for (unsigned int b = 0; b < 256; b++)
+        {
+            if (n->children[b] != 0)
+            {
+                shrunk->children[shrunk->count] = n->children[b];
+                shrunk->index[b] = static_cast<uint8_t>(shrunk->count + 1);
+                shrunk->count++;
+            }
+        }
+        delete n;
+        ref = FromNode(shrunk);
+        return;
+    }
+    }
+}
+
+void AdaptiveRadixTree::Insert(Child& ref, uint32_t key, unsigned int depth)
+{
+    if (ref == 0)
+    {
+        ref = MakeLeaf(key);
+        return;
+    }
+
+    if (IsLeaf(ref))
+    {
+        uint32_t existing = LeafKey(ref);
+        if (existing == key)
+        {
+            return;
+        }
+        // bytes both keys share become the prefix of a node with the two leaves
+        Node4* node = new Node4();
+        unsigned int length = 0;
+        while (KeyByte(existing, depth + length) == KeyByte(key, depth + length))
+        {
+            node->prefix[length] = KeyByte(key, depth + length);
+            length++;
+        }
+        node->prefixLength = static_cast<uint8_t>(length);
+        Child leaf = ref;
+        ref = FromNode(node);
+        AddChild(ref, node, KeyByte(existing, depth + length), leaf);
+        AddChild(ref, node, KeyByte(key, depth + length), MakeLeaf(key));
+        return;
+    }
+
+    Node* node = ToNode(ref);
+    for (unsigned int i = 0; i < node->prefixLength; i++)
+    {
+        if (node->prefix[i] == KeyByte(key, depth + i))
+        {
+            continue;
+        }
+        // key leaves the prefix here, a new node takes the shared part
+        Node4* parent = new Node4();
+        parent->prefixLength = static_cast<uint8_t>(i);
+        std::memcpy(parent->prefix, node->prefix, i);
+        uint8_t nodeByte = node->prefix[i];
+        node->prefixLength = static_cast<uint8_t>(node->prefixLength - i - 1);
+        std::memmove(node->prefix, node->prefix + i + 1, node->prefixLength);
+        ref = FromNode(parent);
+        AddChild(ref, parent, nodeByte, FromNode(node));
+        AddChild(ref, parent, KeyByte(key, depth + i), MakeLeaf(key));
+        return;
+    }
+    depth += node->prefixLength;
+
+    uint8_t byte = KeyByte(key, depth);
+    Child* child = FindChild(node, byte);
+    if (child != nullptr)
+    {
+        Insert(*child, key, depth + 1);
+        return;
+    }
+    AddChild(ref, node, byte, MakeLeaf(key));
+}
+
+// ref points to an inner node
+bool AdaptiveRadixTree::Remove(Child& ref, uint32_t key, unsigned int depth)
+{
+    Node* node = ToNode(ref);
+    for (unsigned int i = 0; i < node->prefixLength; i++)
+    {
+        if (node->prefix[i] != KeyByte(key, depth + i))
+        {
+            return false;
+        }
+    }
+    depth += node->prefixLength;
+
+    uint8_t byte = KeyByte(key, depth);
+    Child* child = FindChild(node, byte);
+    if (child == nullptr)
+    {
+        return false;
+    }
+    if (IsLeaf(*child))
+    {
+        if (LeafKey(*child) != key)
+        {
+            return false;
+        }
+        RemoveChild(ref, node, byte);
+        return true;
+    }
+    return Remove(*child, key, depth + 1);
+}
+
+void AdaptiveRadixTree::DeleteNode(Node* node)
+{
+    switch (node->type)
+    {
+    case NodeType::Node4:
+        delete static_cast<Node4*>(node);
+        break;
+    case NodeType::Node16:
+        delete static_cast<Node16*>(node);
+        break;
+    case NodeType::Node48:
+        delete static_cast<Node48*>(node);
+        break;
+    case NodeType::Node256:
+        delete static_cast<Node256*>(node);
+        break;
+    }
+}
+
+void AdaptiveRadixTree::DeleteNodesRecursively(Child child)
+{
+    if (child == 0 || IsLeaf(child))
+    {
+        return;
+    }
+    Node* node = ToNode(child);
+    switch (node->type)
+    {
+    case NodeType::Node4:
+    {
+        Node4* n = static_cast<Node4*>(node);
+        for (unsigned int i = 0; i < n->count; i++)
+        {
+            DeleteNodesRecursively(n->children[i]);
+        }
+        break;
+    }
+    case NodeType::Node16:
+    {
+        Node16* n = static_cast<Node16*>(node);
+        for (unsigned int i = 0; i < n->count; i++)
+        {
+            DeleteNodesRecursively(n->children[i]);
+        }
+        break;
+    }
+    case NodeType::Node48:
+    {
+        Node48* n = static_cast<Node48*>(node);
+        for (unsigned int i = 0; i < n->count; i++)
+        {
+            DeleteNodesRecursively(n->children[i]);
+        }
+        break;
+    }
+    case NodeType::Node256:
+    {
+        Node256* n = static_cast<Node256*>(node);
+        for (Child c : n->children)
+        {
+            DeleteNodesRecursively(c);
+        }
+        break;
+    }
+    }
+    DeleteNode(node);
+}
+
+// children in byte order give keys in order
+void AdaptiveRadixTree::GetVector(Child child, std::vector<int>& vec)
+{
+    if (child == 0)
+    {
+        return;
+    }
+    if (IsLeaf(child))
+    {
+        vec.push_back(static_cast<int>(LeafKey(child) ^ 0x80000000u));
+        return;
+    }
+    Node* node = ToNode(child);
+    switch (node->type)
+    {
+    case NodeType::Node4:
+    {
+        Node4* n = static_cast<Node4*>(node);
+        for (unsigned int i = 0; i < n->count; i++)
+        {
+            GetVector(n->children[i], vec);
+        }
+        break;
+    }
+    case NodeType::Node16:
+    {
+        Node16* n = static_cast<Node16*>(node);
+        for (unsigned int i = 0; i < n->count; i++)
+        {
+            GetVector(n->children[i], vec);
+        }
+        break;
+    }
+    case NodeType::Node48:
+    {
+        Node48* n = static_cast<Node48*>(node);
+        for (unsigned int b = 0; b < 256; b++)
+        {
+            if (n->index[b] != 0)
+            {
+                GetVector(n->children[n->index[b] - 1], vec);
+            }
+        }
+        break;
+    }
+    case NodeType::Node256:
+    {
+        Node256* n = static_cast<Node256*>(node);
+        for (Child c : n->children)
+        {
+            GetVector(c, vec);
+        }
+        break;
+    }
+    }
+}
+
+// number of nodes on the longest path, leaves included
+size_t AdaptiveRadixTree::Height(Child child)
+{
+    if (child == 0)
+    {
+        return 0;
+    }
+    if (IsLeaf(child))
+    {
+        return 1;
+    }
+    Node* node = ToNode(child);
+    size_t height = 0;
+    switch (node->type)
+    {
+    case NodeType::Node4:
+    {
+        Node4* n = static_cast<Node4*>(node);
+        for (unsigned int i = 0; i < n->count; i++)
+        {
+            height = std::max(height, Height(n->children[i]));
+        }
+        break;
+    }
+    case NodeType::Node16:
+    {
+        Node16* n = static_cast<Node16*>(node);
+        for (unsigned int i = 0; i < n->count; i++)
+        {
+            height = std::max(height, Height(n->children[i]));
+        }
+        break;
+    }
+    case NodeType::Node48:
+    {
+        Node48* n = static_cast<Node48*>(node);
+        for (unsigned int i = 0; i < n->count; i++)
+        {
+            height = std::max(height, Height(n->children[i]));
+        }
+        break;
+    }
+    case NodeType::Node256:
+    {
+        Node256* n = static_cast<Node256*>(node);
+        for (Child c : n->children)
+        {
+            height = std::max(height, Height(c));
+        }
+        break;
+    }
+    }
+    return height + 1;
+}
+
+size_t AdaptiveRadixTree::MemoryUsage(Child child)
+{
+    if (child == 0 || IsLeaf(child))
+    {
+        return 0;
+    }
+    Node* node = ToNode(child);
+    size_t bytes = 0;
+    switch (node->type)
+    {
+    case NodeType::Node4:
+    {
+        Node4* n = static_cast<Node4*>(node);
+        bytes = sizeof(Node4);
+        for (unsigned int i = 0; i < n->count; i++)
+        {
+            bytes += MemoryUsage(n->children[i]);
+        }
+        break;
+    }
+    case NodeType::Node16:
+    {
+        Node16* n = static_cast<Node16*>(node);
+        bytes = sizeof(Node16);
+        for (unsigned int i = 0; i < n->count; i++)
+        {
+            bytes += MemoryUsage(n->children[i]);
+        }
+        break;
+    }
+    case NodeType::Node48:
+    {
+        Node48* n = static_cast<Node48*>(node);
+        bytes = sizeof(Node48);
+        for (unsigned int i = 0; i < n->count; i++)
+        {
+            bytes += MemoryUsage(n->children[i]);
+        }
+        break;
+    }
+    case NodeType::Node256:
+    {
+        Node256* n = static_cast<Node256*>(node);
+        bytes = sizeof(Node256);
+        for (Child c : n->children)
+        {
+            bytes += MemoryUsage(c);
+        }
+        break;
+    }
+    }
+    return bytes;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Adaptive radix tree over the 4 bytes of a key, most significant first, with
+// the sign bit flipped so byte order is key order. Inner nodes grow and shrink
+// between Node4, Node16, Node48 and Node256 with their number of children.
+// Bytes all keys below a node share are kept in its prefix instead of
+// single-child nodes. Leaves hold the whole key in the child slot, no memory.
+class AdaptiveRadixTree
+{
+public:
+    AdaptiveRadixTree();
+    ~AdaptiveRadixTree();
+
+    void Insert(int key);
+    void Remove(int key);
+    bool Find(int key);
+    void Clear();
+    // keys in order
+    std::vector<int> GetVector();
+    size_t Height();
+    size_t MemoryUsage();
+
+private:
+
+    enum class NodeType : uint8_t { Node4, Node16, Node48, Node256 };
+
+    // 0 if empty, key << 32 | 1 for a leaf, otherwise address of a node
+    using Child = uint64_t;
+
+    struct Node
+    {
+        NodeType type;
+        uint8_t prefixLength;
+        uint16_t count;
+        // keys have 4 bytes and every node consumes one, so a prefix is at most 3
+        uint8_t prefix[3];
+
+        Node(NodeType type);
+    };
+
+    // keys sorted
+    struct Node4 : Node
+    {
+        uint8_t keys[4];
+        Child children[4];
+
+        Node4();
+    };
+
+    // keys sorted
+    struct Node16 : Node
+    {
+        uint8_t keys[16];
+        Child children[16];
+
+        Node16();
+    };
+
+    // index holds slot + 1 for each byte, 0 if absent; slots [0, count) are used
+    struct Node48 : Node
+    {
+        uint8_t index[256];
+        Child children[48];
+
+        Node48();
+    };
+
+    struct Node256 : Node
+    {
+        Child children[256];
+
+        Node256();
+    };
+
+    static bool IsLeaf(Child child);
+    static Child MakeLeaf(uint32_t key);
+    static uint32_t LeafKey(Child child);
+    static Node* ToNode(Child child);
+    static Child FromNode(Node* node);
+    static uint32_t ToRadix(int key);
+    static uint8_t KeyByte(uint32_t key, unsigned int depth);
+    static void CopyPrefix(Node* to, const Node* from);
+
+    Child* FindChild(Node* node, uint8_t byte);
+    // ref is the slot pointing to node, it changes when node grows or shrinks
+    void AddChild(Child& ref, Node* node, uint8_t byte, Child child);
+    void RemoveChild(Child& ref, Node* node, uint8_t byte);
+    void Insert(Child& ref, uint32_t key, unsigned int depth);
+    bool Remove(Child& ref, uint32_t key, unsigned int depth);
+    void DeleteNode(Node* node);
+    void DeleteNodesRecursively(Child child);
+    void GetVector(Child child, std::vector<int>& vec);
+    size_t Height(Child child);
+    size_t MemoryUsage(Child child);
+
+    Child root;
+};
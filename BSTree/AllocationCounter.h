@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstddef>
+
+// Number of global operator new calls made by the calling thread so far.
+// Counting replaces the global operator new and delete for the whole program,
+// which would change the timings of every other test, so AllocationCounter.cpp
+// does it only when COUNT_ALLOCATIONS is defined; otherwise the count stays 0.
+// Over-aligned allocations go to the default operators and are not counted.
+size_t AllocationCount();
+// whether the program is built with COUNT_ALLOCATIONS
+bool AllocationsCounted();
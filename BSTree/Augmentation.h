@@ -0,0 +1,16 @@
+#pragma once
+
+// Augmentation policies of RBTreeBase and AVLTreeBase. An augmentation has
+// enabled, false if it keeps nothing, and Update(node), which recomputes
+// what node keeps about its subtree from node and its children.
+
+// keeps nothing, the plain balanced tree
+struct NoAugmentation
+{
+    static const bool enabled = false;
+
+    template <typename Node>
+    static void Update(Node*)
+    {
+    }
+};
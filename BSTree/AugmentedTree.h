@@ -0,0 +1,305 @@
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <vector>
+#include "AVLTreeBase.h"
+#include "RBTreeBase.h"
+
+// Monoid examples. A monoid provides Value type, Identity() and associative Combine(a, b).
+struct SumMonoid
+{
+    using Value = long long;
+    static Value Identity() { return 0; }
+    static Value Combine(const Value& a, const Value& b) { return a + b; }
+};
+
+struct MinMonoid
+{
+    using Value = int;
+    static Value Identity() { return INT_MAX; }
+    static Value Combine(const Value& a, const Value& b) { return std::min(a, b); }
+};
+
+struct MaxMonoid
+{
+    using Value = int;
+    static Value Identity() { return INT_MIN; }
+    static Value Combine(const Value& a, const Value& b) { return std::max(a, b); }
+};
+
+// key and value of an AugmentedTree node and aggregate of its subtree,
+// Identity() in the red-black sentinel
+template <typename Monoid>
+struct AugmentedTreeEntry
+{
+    int key;
+    typename Monoid::Value value = Monoid::Identity();
+    typename Monoid::Value aggregate = Monoid::Identity();
+};
+
+// keeps aggregate of AugmentedTreeEntry, in key order
+template <typename Monoid>
+struct MonoidAugmentation
+{
+    static const bool enabled = true;
+
+    template <typename Node>
+    static typename Monoid::Value Aggregate(const Node* node)
+    {
+        return node == nullptr ? Monoid::Identity() : node->aggregate;
+    }
+
+    template <typename Node>
+    static void Update(Node* node)
+    {
+        node->aggregate = Monoid::Combine(Monoid::Combine(Aggregate(node->left), node->value), Aggregate(node->right));
+    }
+};
+
+// Balanced tree mapping int keys to Monoid::Value, on top of AVLTreeBase or RBTreeBase.
+// Every node keeps the aggregate of its subtree in key order, recomputed by the base
+// wherever the subtree changes, so Aggregate(lo, hi) takes O(log n).
+// Combine needs not be commutative.
+template <typename Monoid, template <typename, typename> class Base>
+class AugmentedTree : private Base<AugmentedTreeEntry<Monoid>, MonoidAugmentation<Monoid>>
+{
+public:
+    using Value = typename Monoid::Value;
+
+    AugmentedTree();
+    ~AugmentedTree();
+    // insert key or replace its value
+    void Insert(int key, const Value& value);
+    void Remove(int key);
+    bool Find(int key);
+    // aggregate of values with keys in [lo, hi], Identity() if there are none
+    Value Aggregate(int lo, int hi);
+    int Height();
+    void Clear();
+    std::vector<int> GetVector();
+
+private:
+    using Tree = Base<AugmentedTreeEntry<Monoid>, MonoidAugmentation<Monoid>>;
+    using typename Tree::Node;
+    using Tree::nil;
+    using Tree::root;
+    using Tree::InsertLeaf;
+    using Tree::Unlink;
+    using Tree::UpdateUp;
+
+    Node* FindNode(int key);
+    Value Aggregate(Node* node);
+    void DeleteNodesRecursively(Node* node);
+    void GetVector(Node* node, std::vector<int>& vec);
+    int Height(Node* node);
+};
+
+template <typename Monoid>
+using AugmentedAVLTree = AugmentedTree<Monoid, AVLTreeBase>;
+
+template <typename Monoid>
+using AugmentedRBTree = AugmentedTree<Monoid, RBTreeBase>;
+
+template <typename Monoid, template <typename, typename> class Base>
+AugmentedTree<Monoid, Base>::AugmentedTree()
+{
+}
+
+template <typename Monoid, template <typename, typename> class Base>
+AugmentedTree<Monoid, Base>::~AugmentedTree()
+{
+    DeleteNodesRecursively(root);
+}
+
+template <typename Monoid, template <typename, typename> class Base>
+void AugmentedTree<Monoid, Base>::Insert(int key, const Value& value)
+{
+    Node* parent = nil;
+    Node* node = root;
+
+    // find insertion position
+    while (node != nil)
+    {
+        if (key == node->key)
+        {
+            // existing key, no structural changes
+            node->value = value;
+            UpdateUp(node);
+            return;
+        }
+
+        parent = node;
+        if (key < node->key)
+        {
+            node = node->left;
+        }
+        else
+        {
+            node = node->right;
+        }
+    }
+
+    // insert
+    node = new Node;
+    node->key = key;
+    node->value = value;
+    InsertLeaf(node, parent, parent != nil && key < parent->key);
+}
+
+template <typename Monoid, template <typename, typename> class Base>
+void AugmentedTree<Monoid, Base>::Remove(int key)
+{
+    Node* node = FindNode(key);
+    if (node == nil)
+    {
+        return;
+    }
+    delete Unlink(node);
+}
+
+template <typename Monoid, template <typename, typename> class Base>
+bool AugmentedTree<Monoid, Base>::Find(int key)
+{
+    return FindNode(key) != nil;
+}
+
+template <typename Monoid, template <typename, typename> class Base>
+typename AugmentedTree<Monoid, Base>::Node* AugmentedTree<Monoid, Base>::FindNode(int key)
+{
+    Node* node = root;
+    while (node != nil)
+    {
+        if (node->key == key)
+        {
+            return node;
+        }
+        if (key < node->key)
+        {
+            node = node->left;
+        }
+        else
+        {
+            node = node->right;
+        }
+    }
+    return nil;
+}
+
+template <typename Monoid, template <typename, typename> class Base>
+typename AugmentedTree<Monoid, Base>::Value AugmentedTree<Monoid, Base>::Aggregate(int lo, int hi)
+{
+    // go down to the split node, the first one inside [lo, hi]
+    Node* split = root;
+    while (split != nil && (split->key < lo || split->key > hi))
+    {
+        if (split->key < lo)
+        {
+            split = split->right;
+        }
+        else
+        {
+            split = split->left;
+        }
+    }
+    if (split == nil)
+    {
+        return Monoid::Identity();
+    }
+
+    // left path: every node >= lo adds itself and its right subtree in front of the suffix
+    Value suffix = Monoid::Identity();
+    Node* node = split->left;
+    while (node != nil)
+    {
+        if (node->key >= lo)
+        {
+            suffix = Monoid::Combine(Monoid::Combine(node->value, Aggregate(node->right)), suffix);
+            node = node->left;
+        }
+        else
+        {
+            node = node->right;
+        }
+    }
+
+    // right path: every node <= hi adds its left subtree and itself after the prefix
+    Value prefix = Monoid::Identity();
+    node = split->right;
+    while (node != nil)
+    {
+        if (node->key <= hi)
+        {
+            prefix = Monoid::Combine(prefix, Monoid::Combine(Aggregate(node->left), node->value));
+            node = node->right;
+        }
+        else
+        {
+            node = node->left;
+        }
+    }
+
+    return Monoid::Combine(Monoid::Combine(suffix, split->value), prefix);
+}
+
+template <typename Monoid, template <typename, typename> class Base>
+typename AugmentedTree<Monoid, Base>::Value AugmentedTree<Monoid, Base>::Aggregate(Node* node)
+{
+    return MonoidAugmentation<Monoid>::Aggregate(node);
+}
+
+template <typename Monoid, template <typename, typename> class Base>
+int AugmentedTree<Monoid, Base>::Height()
+{
+    return Height(root);
+}
+
+template <typename Monoid, template <typename, typename> class Base>
+int AugmentedTree<Monoid, Base>::Height(Node* node)
+{
+    if (node == nil)
+    {
+        return 0;
+    }
+    return std::max(Height(node->left), Height(node->right)) + 1;
+}
+
+template <typename Monoid, template <typename, typename> class Base>
+void AugmentedTree<Monoid, Base>::Clear()
+{
+    DeleteNodesRecursively(root);
+    root = nil;
+}
+
+template <typename Monoid, template <typename, typename> class Base>
+void AugmentedTree<Monoid, Base>::DeleteNodesRecursively(Node* node)
+{
+    if (node == nil)
+    {
+        return;
+    }
+    DeleteNodesRecursively(node->left);
+    DeleteNodesRecursively(node->right);
+    delete node;
+}
+
+template <typename Monoid, template <typename, typename> class Base>
+std::vector<int> AugmentedTree<Monoid, Base>::GetVector()
+{
+    std::vector<int> values;
+    GetVector(root, values);
+    return values;
+}
+
+template <typename Monoid, template <typename, typename> class Base>
+void AugmentedTree<Monoid, Base>::GetVector(Node* node, std::vector<int>& vec)
+{
+    if (node == nil)
+    {
+        return;
+    }
+    GetVector(node->left, vec);
+    vec.push_back(node->key);
+    GetVector(node->right, vec);
+}
@@ -0,0 +1,378 @@
+#include "BEpsilonTree.h"
+#include <algorithm>
+#include <cassert>
+
+BEpsilonTree::Node::Node(bool leaf) :
+    leaf{ leaf }
+{
+}
+
+BEpsilonTree::Node::~Node()
+{
+    for (Node* child : children)
+    {
+        delete child;
+    }
+}
+
+BEpsilonTree::BEpsilonTree(size_t fanout, size_t bufferSize) :
+    fanout{ fanout },
+    bufferSize{ bufferSize },
+    root{ new Node(false) }
+{
+    assert(fanout >= 4 && bufferSize >= 4);
+    root->children.push_back(new Node(true));
+}
+
+BEpsilonTree::~BEpsilonTree()
+{
+    delete root;
+}
+
+void BEpsilonTree::Insert(int key)
+{
+    Put(key, true);
+}
+
+void BEpsilonTree::Remove(int key)
+{
+    Put(key, false);
+}
+
+bool BEpsilonTree::Find(int key)
+{
+    Node* node = root;
+    while (!node->leaf)
+    {
+        auto message = std::lower_bound(node->buffer.begin(), node->buffer.end(), key, [](const Message& m, int k) { return m.key < k; });
+        if (message != node->buffer.end() && message->key == key)
+        {
+            return message->insert;
+        }
+        node = node->children[ChildIndex(node, key)];
+    }
+    return std::binary_search(node->keys.begin(), node->keys.end(), key);
+}
+
+int BEpsilonTree::Height()
+{
+    return Height(root);
+}
+
+void BEpsilonTree::Clear()
+{
+    delete root;
+    root = new Node(false);
+    root->children.push_back(new Node(true));
+}
+
+std::vector<int> BEpsilonTree::GetVector()
+{
+    std::vector<int> vec;
+    GetVector(root, vec);
+    return vec;
+}
+
+size_t BEpsilonTree::MemoryUsage()
+{
+    return MemoryUsage(root);
+}
+
+// a newer message for the same key replaces the buffered one
+void BEpsilonTree::Put(int key, bool insert)
+{
+    std::vector<Message>& buffer = root->buffer;
+    auto message = std::lower_bound(buffer.begin(), buffer.end(), key, [](const Message& m, int k) { return m.key < k; });
+    if (message != buffer.end() && message->key == key)
+    {
+        message->insert = insert;
+        return;
+    }
+    buffer.insert(message, Message{ key, insert });
+    if (buffer.size() <= bufferSize)
+    {
+        return;
+    }
+
+    Flush(root);
+    // grow a level when the root has too many children
+    while (IsOverfull(root))
+    {
+        Node* newRoot = new Node(false);
+        newRoot->children.push_back(root);
+        root = newRoot;
+        Split(root, 0);
+    }
+    // shrink a level when merges left the root with a single inner child
+    while (root->children.size() == 1 && !root->children[0]->leaf)
+    {
+        Node* child = root->children[0];
+        Apply(child, root->buffer.data(), root->buffer.data() + root->buffer.size());
+        root->children.clear();
+        delete root;
+        root = child;
+        if (root->buffer.size() > bufferSize)
+        {
+            Flush(root);
+        }
+    }
+}
+
+// moves the messages of the child with the most of them down until the buffer fits
+void BEpsilonTree::Flush(Node* node)
+{
+    while (node->buffer.size() > bufferSize)
+    {
+        size_t bestChild = 0;
+        size_t bestFirst = 0;
+        size_t bestCount = 0;
+        size_t child = 0;
+        size_t first = 0;
+        for (size_t i = 0; i <= node->buffer.size(); i++)
+        {
+            // messages are sorted, so each child has a contiguous run
+            if (i == node->buffer.size() || (child < node->keys.size() && node->buffer[i].key >= node->keys[child]))
+            {
+                if (i - first > bestCount)
+                {
+                    bestChild = child;
+                    bestFirst = first;
+                    bestCount = i - first;
+                }
+                if (i == node->buffer.size())
+                {
+                    break;
+                }
+                child = ChildIndex(node, node->buffer[i].key);
+                first = i;
+            }
+        }
+
+        Node* target = node->children[bestChild];
+        const Message* messages = node->buffer.data() + bestFirst;
+        Apply(target, messages, messages + bestCount);
+        node->buffer.erase(node->buffer.begin() + bestFirst, node->buffer.begin() + bestFirst + bestCount);
+        if (!target->leaf && target->buffer.size() > bufferSize)
+        {
+            Flush(target);
+        }
+        FixChild(node, bestChild);
+    }
+}
+
+void BEpsilonTree::Apply(Node* node, const Message* first, const Message* last)
+{
+    if (first == last)
+    {
+        return;
+    }
+    if (node->leaf)
+    {
+        std::vector<int> keys;
+        keys.reserve(node->keys.size() + (last - first));
+        MergeMessages(node->keys, first, last, keys);
+        node->keys.swap(keys);
+        return;
+    }
+
+    std::vector<Message> buffer;
+    buffer.reserve(node->buffer.size() + (last - first));
+    auto older = node->buffer.cbegin();
+    while (older != node->buffer.cend() && first != last)
+    {
+        if (older->key < first->key)
+        {
+            buffer.push_back(*older++);
+        }
+        else
+        {
+            if (older->key == first->key)
+            {
+                older++;
+            }
+            buffer.push_back(*first++);
+        }
+    }
+    buffer.insert(buffer.end(), older, node->buffer.cend());
+    buffer.insert(buffer.end(), first, last);
+    node->buffer.swap(buffer);
+}
+
+void BEpsilonTree::FixChild(Node* parent, size_t index)
+{
+    if (IsUnderfull(parent->children[index]) && parent->children.size() > 1)
+    {
+        if (index == parent->children.size() - 1)
+        {
+            index--;
+        }
+        Merge(parent, index);
+        Node* merged = parent->children[index];
+        if (!merged->leaf && merged->buffer.size() > bufferSize)
+        {
+            Flush(merged);
+        }
+    }
+    if (IsOverfull(parent->children[index]))
+    {
+        Split(parent, index);
+    }
+}
+
+// halves the child until no piece is overfull
+void BEpsilonTree::Split(Node* parent, size_t index)
+{
+    size_t end = index + 1;
+    while (index < end)
+    {
+        Node* left = parent->children[index];
+        if (!IsOverfull(left))
+        {
+            index++;
+            continue;
+        }
+
+        Node* right = new Node(left->leaf);
+        int pivot;
+        if (left->leaf)
+        {
+            size_t half = left->keys.size() / 2;
+            right->keys.assign(left->keys.begin() + half, left->keys.end());
+            left->keys.resize(half);
+            pivot = right->keys[0];
+        }
+        else
+        {
+            size_t half = left->children.size() / 2;
+            pivot = left->keys[half - 1];
+            right->keys.assign(left->keys.begin() + half, left->keys.end());
+            left->keys.resize(half - 1);
+            right->children.assign(left->children.begin() + half, left->children.end());
+            left->children.resize(half);
+            auto middle = std::lower_bound(left->buffer.begin(), left->buffer.end(), pivot, [](const Message& m, int k) { return m.key < k; });
+            right->buffer.assign(middle, left->buffer.end());
+            left->buffer.erase(middle, left->buffer.end());
+        }
+        parent->keys.insert(parent->keys.begin() + index, pivot);
+        parent->children.insert(parent->children.begin() + index + 1, right);
+        end++;
+    }
+}
+
+// joins children index and index + 1 into children index
+void BEpsilonTree::Merge(Node* parent, size_t index)
+{
+    Node* left = parent->children[index];
+    Node* right = parent->children[index + 1];
+    if (!left->leaf)
+    {
+        // the pivot between them comes down, buffers cover disjoint ranges
+        left->keys.push_back(parent->keys[index]);
+        left->children.insert(left->children.end(), right->children.begin(), right->children.end());
+        left->buffer.insert(left->buffer.end(), right->buffer.begin(), right->buffer.end());
+        right->children.clear();
+    }
+    left->keys.insert(left->keys.end(), right->keys.begin(), right->keys.end());
+    parent->keys.erase(parent->keys.begin() + index);
+    parent->children.erase(parent->children.begin() + index + 1);
+    delete right;
+}
+
+bool BEpsilonTree::IsOverfull(Node* node)
+{
+    if (node->leaf)
+    {
+        return node->keys.size() > bufferSize;
+    }
+    return node->children.size() > fanout;
+}
+
+bool BEpsilonTree::IsUnderfull(Node* node)
+{
+    if (node->leaf)
+    {
+        return node->keys.size() < bufferSize / 4;
+    }
+    return node->children.size() < std::max<size_t>(fanout / 4, 2);
+}
+
+size_t BEpsilonTree::ChildIndex(Node* node, int key)
+{
+    return std::upper_bound(node->keys.begin(), node->keys.end(), key) - node->keys.begin();
+}
+
+void BEpsilonTree::MergeMessages(const std::vector<int>& keys, const Message* first, const Message* last, std::vector<int>& out)
+{
+    auto key = keys.cbegin();
+    while (key != keys.cend() && first != last)
+    {
+        if (*key < first->key)
+        {
+            out.push_back(*key++);
+            continue;
+        }
+        if (*key == first->key)
+        {
+            key++;
+        }
+        if (first->insert)
+        {
+            out.push_back(first->key);
+        }
+        first++;
+    }
+    out.insert(out.end(), key, keys.cend());
+    for (; first != last; first++)
+    {
+        if (first->insert)
+        {
+            out.push_back(first->key);
+        }
+    }
+}
+
+// all leaves are at the same depth
+int BEpsilonTree::Height(Node* node)
+{
+    int height = 1;
+    while (!node->leaf)
+    {
+        node = node->children[0];
+        height++;
+    }
+    return height;
+}
+
+void BEpsilonTree::GetVector(Node* node, std::vector<int>& vec)
+{
+    if (node->leaf)
+    {
+        vec.insert(vec.end(), node->keys.begin(), node->keys.end());
+        return;
+    }
+    if (node->buffer.empty())
+    {
+        for (Node* child : node->children)
+        {
+            GetVector(child, vec);
+        }
+        return;
+    }
+    // pending messages override what is below them
+    std::vector<int> below;
+    for (Node* child : node->children)
+    {
+        GetVector(child, below);
+    }
+    MergeMessages(below, node->buffer.data(), node->buffer.data() + node->buffer.size(), vec);
+}
+
+size_t BEpsilonTree::MemoryUsage(Node* node)
+{
+    size_t bytes = sizeof(Node) + node->keys.capacity() * sizeof(int) + node->children.capacity() * sizeof(Node*) + node->buffer.capacity() * sizeof(Message);
+    for (Node* child : node->children)
+    {
+        bytes += MemoryUsage(child);
+    }
+    return bytes;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Write-optimized B-tree (B-epsilon tree). Inner nodes have a buffer of pending
+// inserts and removes besides their pivots; updates only go into the root
+// buffer, and a full buffer moves the messages of its busiest child down in
+// one batch, so an update costs O(log(n) / fanout) node visits amortized
+// instead of a root-to-leaf walk. Find checks buffers on its way down, the
+// first message for the key is the newest one.
+class BEpsilonTree
+{
+public:
+
+    // leaves hold up to bufferSize keys
+    BEpsilonTree(size_t fanout = 16, size_t bufferSize = 256);
+    ~BEpsilonTree();
+    void Insert(int key);
+    void Remove(int key);
+    bool Find(int key);
+    int Height();
+    void Clear();
+    std::vector<int> GetVector();
+    size_t MemoryUsage();
+
+private:
+
+    struct Message
+    {
+        int key;
+        bool insert;
+    };
+
+    struct Node
+    {
+        bool leaf;
+        // keys of a leaf, pivots of an inner node: child i has keys in [keys[i - 1], keys[i])
+        std::vector<int> keys;
+        std::vector<Node*> children;
+        // sorted by key, at most one message per key
+        std::vector<Message> buffer;
+
+        Node(bool leaf);
+        ~Node();
+    };
+
+    void Put(int key, bool insert);
+    void Flush(Node* node);
+    // merges newer messages into a sorted buffer or applies them to leaf keys
+    void Apply(Node* node, const Message* first, const Message* last);
+    // merges an underfull child with a neighbour, splits an overfull one
+    void FixChild(Node* parent, size_t index);
+    void Split(Node* parent, size_t index);
+    void Merge(Node* parent, size_t index);
+    bool IsOverfull(Node* node);
+    bool IsUnderfull(Node* node);
+    size_t ChildIndex(Node* node, int key);
+    // keys with messages applied, appended to out
+    static void MergeMessages(const std::vector<int>& keys, const Message* first, const Message* last, std::vector<int>& out);
+    int Height(Node* node);
+    void GetVector(Node* node, std::vector<int>& vec);
+    size_t MemoryUsage(Node* node);
+
+    size_t fanout;
+    size_t bufferSize;
+    // always an inner node so updates always have a buffer to go to
+    Node* root;
+};
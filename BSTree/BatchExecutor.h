@@ -0,0 +1,183 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Coroutine front end of a tree: co_await executor.Find(key) queues the lookup
+// and suspends the caller. Run drains the queue in batches; runs of queued
+// Finds go to tree.FindBatch, so descents of many tasks overlap their cache
+// misses. Operations are applied in queue order, then callers are resumed.
+// T is AVLTree, AVLTreeIterative or RBTree. Not thread safe, Run is the event loop.
+template <typename T>
+class BatchExecutor
+{
+    enum class Kind { Find, Insert, Remove };
+
+public:
+    BatchExecutor(T& tree, size_t batchSize = 256);
+
+    class FindOperation
+    {
+    public:
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) { executor.Enqueue(Kind::Find, key, handle, &found); }
+        bool await_resume() const noexcept { return found; }
+
+    private:
+        friend class BatchExecutor;
+        FindOperation(BatchExecutor& executor, int key) : executor{ executor }, key{ key }, found{ false } {}
+
+        BatchExecutor& executor;
+        int key;
+        bool found;
+    };
+
+    class WriteOperation
+    {
+    public:
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) { executor.Enqueue(kind, key, handle, nullptr); }
+        void await_resume() const noexcept {}
+
+    private:
+        friend class BatchExecutor;
+        WriteOperation(BatchExecutor& executor, int key, Kind kind) : executor{ executor }, key{ key }, kind{ kind } {}
+
+        BatchExecutor& executor;
+        int key;
+        Kind kind;
+    };
+
+    FindOperation Find(int key);
+    WriteOperation Insert(int key);
+    WriteOperation Remove(int key);
+    // process queued operations and resume their callers until nothing is queued, returns number of operations
+    size_t Run();
+    size_t Pending() const;
+
+private:
+
+    struct Request
+    {
+        Kind kind;
+        int key;
+        std::coroutine_handle<> handle;
+        bool* found;
+    };
+
+    void Enqueue(Kind kind, int key, std::coroutine_handle<> handle, bool* found);
+    void FlushFinds(std::vector<Request>& requests, size_t first, size_t last);
+
+    T& tree;
+    size_t batchSize;
+    std::vector<Request> queue;
+    std::vector<Request> running;
+    std::vector<int> batchKeys;
+    std::vector<bool> batchFound;
+};
+
+template <typename T>
+BatchExecutor<T>::BatchExecutor(T& tree, size_t batchSize) :
+    tree{ tree },
+    batchSize{ batchSize }
+{
+}
+
+template <typename T>
+typename BatchExecutor<T>::FindOperation BatchExecutor<T>::Find(int key)
+{
+    return FindOperation(*this, key);
+}
+
+template <typename T>
+typename BatchExecutor<T>::WriteOperation BatchExecutor<T>::Insert(int key)
+{
+    return WriteOperation(*this, key, Kind::Insert);
+}
+
+template <typename T>
+typename BatchExecutor<T>::WriteOperation BatchExecutor<T>::Remove(int key)
+{
+    return WriteOperation(*this, key, Kind::Remove);
+}
+
+template <typename T>
+size_t BatchExecutor<T>::Pending() const
+{
+    return queue.size();
+}
+
+template <typename T>
+void BatchExecutor<T>::Enqueue(Kind kind, int key, std::coroutine_handle<> handle, bool* found)
+{
+    queue.push_back(Request{ kind, key, handle, found });
+}
+
+template <typename T>
+size_t BatchExecutor<T>::Run()
+{
+    size_t processed = 0;
+    while (!queue.empty())
+    {
+        // resumed callers queue their next operations for the next round
+        std::swap(queue, running);
+        queue.clear();
+
+        size_t findsStart = 0;
+        for (size_t i = 0; i < running.size(); i++)
+        {
+            const Request& request = running[i];
+            if (request.kind == Kind::Find)
+            {
+                if (i + 1 - findsStart == batchSize)
+                {
+                    FlushFinds(running, findsStart, i + 1);
+                    findsStart = i + 1;
+                }
+                continue;
+            }
+            // a write ends the run of finds before it
+            FlushFinds(running, findsStart, i);
+            findsStart = i + 1;
+            if (request.kind == Kind::Insert)
+            {
+                tree.Insert(request.key);
+            }
+            else
+            {
+                tree.Remove(request.key);
+            }
+        }
+        FlushFinds(running, findsStart, running.size());
+
+        processed += running.size();
+        for (const Request& request : running)
+        {
+            request.handle.resume();
+        }
+        running.clear();
+    }
+    return processed;
+}
+
+// finds of requests [first, last) in one FindBatch
+template <typename T>
+void BatchExecutor<T>::FlushFinds(std::vector<Request>& requests, size_t first, size_t last)
+{
+    if (first >= last)
+    {
+        return;
+    }
+    batchKeys.clear();
+    for (size_t i = first; i < last; i++)
+    {
+        batchKeys.push_back(requests[i].key);
+    }
+    tree.FindBatch(batchKeys, batchFound);
+    for (size_t i = first; i < last; i++)
+    {
+        *requests[i].found = batchFound[i - first];
+    }
+}
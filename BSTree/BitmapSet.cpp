@@ -0,0 +1,280 @@
+#include "BitmapSet.h"
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace
+{
+    // index of lowest set bit, bits != 0
+    inline unsigned int LowestBit(uint64_t bits)
+    {
+#if defined(_MSC_VER) && defined(_M_X64)
+        unsigned long index;
+        _BitScanForward64(&index, bits);
+        return index;
+#elif defined(_MSC_VER)
+        unsigned long index;
+        if (_BitScanForward(&index, static_cast<unsigned long>(bits)))
+        {
+            return index;
+        }
+        _BitScanForward(&index, static_cast<unsigned long>(bits >> 32));
+        return index + 32;
+#else
+        return __builtin_ctzll(bits);
+#endif
+    }
+
+    // index of highest set bit, bits != 0
+    inline unsigned int HighestBit(uint64_t bits)
+    {
+#if defined(_MSC_VER) && defined(_M_X64)
+        unsigned long index;
+        _BitScanReverse64(&index, bits);
+        return index;
+#elif defined(_MSC_VER)
+        unsigned long index;
+        if (_BitScanReverse(&index, static_cast<unsigned long>(bits >> 32)))
+        {
+            return index + 32;
+        }
+        _BitScanReverse(&index, static_cast<unsigned long>(bits));
+        return index;
+#else
+        return 63 - __builtin_clzll(bits);
+#endif
+    }
+}
+
+BitmapSet::BitmapSet(int universe) :
+    levels(1, std::vector<uint64_t>(1, 0)),
+    size{ 0 }
+{
+    if (universe > 0)
+    {
+        Grow(static_cast<size_t>(universe));
+    }
+}
+
+void BitmapSet::Insert(int key)
+{
+    assert(key >= 0);
+    size_t position = static_cast<size_t>(key);
+    if (position / 64 >= levels[0].size())
+    {
+        Grow(position);
+    }
+    if (levels[0][position / 64] & (uint64_t(1) << (position % 64)))
+    {
+        return;
+    }
+    size++;
+    for (std::vector<uint64_t>& level : levels)
+    {
+        uint64_t& word = level[position / 64];
+        bool wasEmpty = word == 0;
+        word |= uint64_t(1) << (position % 64);
+        // upper levels already have the bit of a non-empty word
+        if (!wasEmpty)
+        {
+            break;
+        }
+        position /= 64;
+    }
+}
+
+void BitmapSet::Remove(int key)
+{
+    if (!Find(key))
+    {
+        return;
+    }
+    size--;
+    size_t position = static_cast<size_t>(key);
+    for (std::vector<uint64_t>& level : levels)
+    {
+        uint64_t& word = level[position / 64];
+        word &= ~(uint64_t(1) << (position % 64));
+        // word still has keys, upper levels keep its bit
+        if (word != 0)
+        {
+            break;
+        }
+        position /= 64;
+    }
+}
+
+bool BitmapSet::Find(int key)
+{
+    size_t position = static_cast<size_t>(key);
+    return key >= 0 && position / 64 < levels[0].size() && (levels[0][position / 64] & (uint64_t(1) << (position % 64))) != 0;
+}
+
+bool BitmapSet::Floor(int key, int& result)
+{
+    if (key < 0)
+    {
+        return false;
+    }
+    size_t position = Previous(static_cast<size_t>(key));
+    if (position == npos)
+    {
+        return false;
+    }
+    result = static_cast<int>(position);
+    return true;
+}
+
+bool BitmapSet::Ceiling(int key, int& result)
+{
+    size_t position = Next(static_cast<size_t>(std::max(key, 0)));
+    if (position == npos)
+    {
+        return false;
+    }
+    result = static_cast<int>(position);
+    return true;
+}
+
+bool BitmapSet::Predecessor(int key, int& result)
+{
+    return key > 0 && Floor(key - 1, result);
+}
+
+bool BitmapSet::Successor(int key, int& result)
+{
+    return key < INT_MAX && Ceiling(key + 1, result);
+}
+
+void BitmapSet::Clear()
+{
+    levels.assign(1, std::vector<uint64_t>(1, 0));
+    size = 0;
+}
+
+std::vector<int> BitmapSet::GetVector()
+{
+    std::vector<int> vec;
+    vec.reserve(size);
+    const std::vector<uint64_t>& keys = levels[0];
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        for (uint64_t bits = keys[i]; bits != 0; bits &= bits - 1)
+        {
+            vec.push_back(static_cast<int>(i * 64 + LowestBit(bits)));
+        }
+    }
+    return vec;
+}
+
+size_t BitmapSet::Size()
+{
+    return size;
+}
+
+size_t BitmapSet::MemoryUsage()
+{
+    size_t bytes = 0;
+    for (const std::vector<uint64_t>& level : levels)
+    {
+        bytes += level.capacity() * sizeof(uint64_t);
+    }
+    return bytes;
+}
+
+// at least doubles the key bitmap, so inserting ascending keys takes amortized constant time
+void BitmapSet::Grow(size_t key)
+{
+    size_t words = std::max(key / 64 + 1, levels[0].size() * 2);
+    for (size_t level = 0; ; level++)
+    {
+        if (level == levels.size())
+        {
+            // new top level gets bits of non-empty words of the old top
+            levels.emplace_back(words, 0);
+            const std::vector<uint64_t>& below = levels[level - 1];
+            for (size_t i = 0; i < below.size(); i++)
+            {
+                if (below[i] != 0)
+                {
+                    levels[level][i / 64] |= uint64_t(1) << (i % 64);
+                }
+            }
+        }
+        else
+        {
+            levels[level].resize(words, 0);
+        }
+        if (words == 1)
+        {
+            break;
+        }
+        words = (words + 63) / 64;
+    }
+}
+
+size_t BitmapSet::Next(size_t position)
+{
+    for (size_t level = 0; level < levels.size(); level++)
+    {
+        size_t word = position / 64;
+        if (word >= levels[level].size())
+        {
+            return npos;
+        }
+        uint64_t bits = levels[level][word] & (~uint64_t(0) << (position % 64));
+        if (bits != 0)
+        {
+            position = word * 64 + LowestBit(bits);
+            // go down to the first key under this bit
+            while (level > 0)
+            {
+                level--;
+                position = position * 64 + LowestBit(levels[level][position]);
+            }
+            return position;
+        }
+        // continue after this word one level up
+        position = word + 1;
+    }
+    return npos;
+}
+
+size_t BitmapSet::Previous(size_t position)
+{
+    for (size_t level = 0; level < levels.size(); level++)
+    {
+        size_t word = position / 64;
+        uint64_t bits = 0;
+        if (word >= levels[level].size())
+        {
+            word = levels[level].size() - 1;
+            bits = levels[level][word];
+        }
+        else
+        {
+            bits = levels[level][word] & (~uint64_t(0) >> (63 - position % 64));
+        }
+        if (bits != 0)
+        {
+            position = word * 64 + HighestBit(bits);
+            // go down to the last key under this bit
+            while (level > 0)
+            {
+                level--;
+                position = position * 64 + HighestBit(levels[level][position]);
+            }
+            return position;
+        }
+        if (word == 0)
+        {
+            return npos;
+        }
+        // continue before this word one level up
+        position = word - 1;
+    }
+    return npos;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Ordered set of non-negative ints as a 64-ary tree of bitmaps. Level 0 has a
+// bit per key, every upper level has a bit per non-empty word of the level
+// below, so successor and predecessor go up to the first word with a candidate
+// and down again with one trailing/leading zero count per level. Memory is one
+// bit per key of the universe [0, largest inserted key], which beats a
+// comparison tree once the set holds more than about 1 key in 300.
+class BitmapSet
+{
+public:
+    // bitmaps grow on demand past universe
+    BitmapSet(int universe = 0);
+
+    void Insert(int key);
+    void Remove(int key);
+    bool Find(int key);
+    // largest key <= key, smallest key >= key, largest key < key, smallest key > key;
+    // return false if there is no such key
+    bool Floor(int key, int& result);
+    bool Ceiling(int key, int& result);
+    bool Predecessor(int key, int& result);
+    bool Successor(int key, int& result);
+    void Clear();
+    std::vector<int> GetVector();
+    size_t Size();
+    size_t MemoryUsage();
+
+private:
+
+    static const size_t npos = SIZE_MAX;
+
+    void Grow(size_t key);
+    // first set key >= position, last set key <= position, npos if there is none
+    size_t Next(size_t position);
+    size_t Previous(size_t position);
+
+    // levels[0] is the key bitmap, the last level is a single word
+    std::vector<std::vector<uint64_t>> levels;
+    size_t size;
+};
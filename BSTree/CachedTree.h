@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Small 2-way set-associative cache of Find results in front of a tree.
+// Both positive and negative lookups are cached; Insert/Remove update the
+// entry of their key in place, so cached results are never stale.
+// T is any of AVLTree, AVLTreeIterative, RBTree (or anything with the same API).
+template <typename T>
+class CachedTree
+{
+public:
+    // capacity - number of cached keys, rounded up to a power of two
+    CachedTree(size_t capacity = 4096);
+
+    void Insert(int key);
+    void Remove(int key);
+    bool Find(int key);
+    void Clear();
+    std::vector<int> GetVector();
+    size_t MemoryUsage();
+
+    size_t Hits() const;
+    size_t Misses() const;
+    double HitRate() const;
+    void ResetCounters();
+
+private:
+
+    enum State : unsigned char { Empty, Absent, Present };
+
+    struct Set
+    {
+        int keys[2];
+        State states[2];
+        unsigned char lru;  // way to replace next
+    };
+
+    Set& GetSet(int key);
+    void Update(int key, State state);
+
+    T tree;
+    std::vector<Set> sets;
+    unsigned int shift;
+    size_t hits;
+    size_t misses;
+};
+
+template <typename T>
+CachedTree<T>::CachedTree(size_t capacity) :
+    shift{ 32 },
+    hits{ 0 },
+    misses{ 0 }
+{
+    size_t numSets = 1;
+    while (numSets * 2 < capacity)
+    {
+        numSets <<= 1;
+        shift--;
+    }
+    sets.resize(numSets, Set{ { 0, 0 }, { Empty, Empty }, 0 });
+}
+
+template <typename T>
+typename CachedTree<T>::Set& CachedTree<T>::GetSet(int key)
+{
+    // Fibonacci hashing, the top bits select the set
+    uint32_t hash = static_cast<uint32_t>(key) * 2654435769u;
+    return sets[shift < 32 ? hash >> shift : 0];
+}
+
+template <typename T>
+void CachedTree<T>::Update(int key, State state)
+{
+    Set& set = GetSet(key);
+    for (int way = 0; way < 2; way++)
+    {
+        if (set.states[way] != Empty && set.keys[way] == key)
+        {
+            set.states[way] = state;
+            return;
+        }
+    }
+}
+
+template <typename T>
+void CachedTree<T>::Insert(int key)
+{
+    tree.Insert(key);
+    Update(key, Present);
+}
+
+template <typename T>
+void CachedTree<T>::Remove(int key)
+{
+    tree.Remove(key);
+    Update(key, Absent);
+}
+
+template <typename T>
+bool CachedTree<T>::Find(int key)
+{
+    Set& set = GetSet(key);
+    for (int way = 0; way < 2; way++)
+    {
+        if (set.states[way] != Empty && set.keys[way] == key)
+        {
+            hits++;
+            set.lru = static_cast<unsigned char>(1 - way);
+            return set.states[way] == Present;
+        }
+    }
+
+    misses++;
+    bool found = tree.Find(key);
+    int way = set.lru;
+    set.keys[way] = key;
+    set.states[way] = found ? Present : Absent;
+    set.lru = static_cast<unsigned char>(1 - way);
+    return found;
+}
+
+template <typename T>
+void CachedTree<T>::Clear()
+{
+    tree.Clear();
+    for (Set& set : sets)
+    {
+        set.states[0] = Empty;
+        set.states[1] = Empty;
+    }
+}
+
+template <typename T>
+std::vector<int> CachedTree<T>::GetVector()
+{
+    return tree.GetVector();
+}
+
+template <typename T>
+size_t CachedTree<T>::MemoryUsage()
+{
+    return tree.MemoryUsage() + sets.size() * sizeof(Set);
+}
+
+template <typename T>
+size_t CachedTree<T>::Hits() const
+{
+    return hits;
+}
+
+template <typename T>
+size_t CachedTree<T>::Misses() const
+{
+    return misses;
+}
+
+template <typename T>
+double CachedTree<T>::HitRate() const
+{
+    size_t total = hits + misses;
+    return total == 0 ? 0.0 : static_cast<double>(hits) / total;
+}
+
+template <typename T>
+void CachedTree<T>::ResetCounters()
+{
+    hits = 0;
+    misses = 0;
+}
@@ -0,0 +1,610 @@
+#include "ConcurrentAVLTree.h"
+#include <algorithm>
+#include <cassert>
+#include <thread>
+
+ConcurrentAVLTree::Node::Node(int key) :
+    key{ key },
+    left{ nullptr },
+    right{ nullptr },
+    version{ 0 },
+    parent{ nullptr },
+    height{ 1 },
+    unlinked{ false }
+{
+}
+
+ConcurrentAVLTree::ConcurrentAVLTree() :
+    root{ nullptr },
+    rootVersion{ 0 },
+    epoch{ 0 }
+{
+    for (auto& stripes : readers)
+    {
+        for (ReaderCount& reader : stripes)
+        {
+            reader.count.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+ConcurrentAVLTree::~ConcurrentAVLTree()
+{
+    Clear();
+}
+
+// writers are readers too: nodes they pass may be removed and retired meanwhile
+void ConcurrentAVLTree::Insert(int key)
+{
+    size_t stripe = ReaderStripe();
+    uint64_t readerEpoch = ReaderEnter(stripe);
+    while (!InsertNode(key))
+    {
+        // another writer changed a node on the path, start again
+    }
+    ReaderExit(stripe, readerEpoch);
+}
+
+void ConcurrentAVLTree::Remove(int key)
+{
+    size_t stripe = ReaderStripe();
+    uint64_t readerEpoch = ReaderEnter(stripe);
+    Node* removed = nullptr;
+    while (!RemoveNode(key, removed))
+    {
+        // another writer changed a node on the path, start again
+    }
+    ReaderExit(stripe, readerEpoch);
+    // outside of the reader section, Synchronize would wait for it
+    if (removed != nullptr)
+    {
+        Retire(removed);
+    }
+}
+
+bool ConcurrentAVLTree::Find(int key)
+{
+    size_t stripe = ReaderStripe();
+    uint64_t readerEpoch = ReaderEnter(stripe);
+    Node* node = nullptr;
+    uint64_t version = 0;
+    bool found = false;
+    while (!FindOptimistic(key, node, version, found))
+    {
+        // a writer changed a node on the path, start again
+    }
+    ReaderExit(stripe, readerEpoch);
+    return found;
+}
+
+std::vector<int> ConcurrentAVLTree::GetVector()
+{
+    std::vector<int> vec;
+    GetVector(root.load(std::memory_order_acquire), vec);
+    return vec;
+}
+
+size_t ConcurrentAVLTree::Height()
+{
+    return Height(root.load(std::memory_order_acquire));
+}
+
+void ConcurrentAVLTree::Clear()
+{
+    DeleteNodesRecursively(root.load(std::memory_order_relaxed));
+    root.store(nullptr, std::memory_order_relaxed);
+    for (Node* node : retired)
+    {
+        delete node;
+    }
+    retired.clear();
+}
+
+// writers read heights of children they haven't locked, acquire loads
+// see content of nodes other writers published
+ConcurrentAVLTree::Node* ConcurrentAVLTree::Left(Node* node)
+{
+    return node->left.load(std::memory_order_acquire);
+}
+
+ConcurrentAVLTree::Node* ConcurrentAVLTree::Right(Node* node)
+{
+    return node->right.load(std::memory_order_acquire);
+}
+
+// release stores publish the content of new nodes to readers
+void ConcurrentAVLTree::SetLeft(Node* node, Node* child)
+{
+    node->left.store(child, std::memory_order_release);
+}
+
+void ConcurrentAVLTree::SetRight(Node* node, Node* child)
+{
+    node->right.store(child, std::memory_order_release);
+}
+
+// replace oldChild of parent with newChild, nullptr parent means root link
+void ConcurrentAVLTree::SetChild(Node* parent, Node* oldChild, Node* newChild)
+{
+    if (parent == nullptr)
+    {
+        root.store(newChild, std::memory_order_release);
+    }
+    else if (Left(parent) == oldChild)
+    {
+        SetLeft(parent, newChild);
+    }
+    else
+    {
+        SetRight(parent, newChild);
+    }
+}
+
+// version is a spin lock of writers, odd version also tells readers to restart;
+// following release stores of links keep the odd store before them
+void ConcurrentAVLTree::Lock(std::atomic<uint64_t>& version)
+{
+    while (true)
+    {
+        uint64_t v = version.load(std::memory_order_relaxed);
+        if (v % 2 == 0 && version.compare_exchange_weak(v, v + 1, std::memory_order_acquire, std::memory_order_relaxed))
+        {
+            return;
+        }
+        std::this_thread::yield();
+    }
+}
+
+bool ConcurrentAVLTree::TryLock(std::atomic<uint64_t>& version, uint64_t expected)
+{
+    assert(expected % 2 == 0);
+    return version.compare_exchange_strong(expected, expected + 1, std::memory_order_acquire, std::memory_order_relaxed);
+}
+
+void ConcurrentAVLTree::Unlock(std::atomic<uint64_t>& version)
+{
+    version.store(version.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+std::atomic<uint64_t>& ConcurrentAVLTree::LinkVersion(Node* parent)
+{
+    return parent == nullptr ? rootVersion : parent->version;
+}
+
+// locks are taken parent before child, and a child only after checking it is
+// still a child of the locked parent, so writers never wait for each other in a cycle
+std::atomic<uint64_t>* ConcurrentAVLTree::LockParent(Node* node)
+{
+    while (!node->unlinked.load(std::memory_order_acquire))
+    {
+        Node* parent = node->parent.load(std::memory_order_acquire);
+        std::atomic<uint64_t>& link = LinkVersion(parent);
+        Lock(link);
+        // a removed parent still points to its old children
+        bool isParent = parent == nullptr ? root.load(std::memory_order_relaxed) == node :
+            !parent->unlinked.load(std::memory_order_relaxed) && (Left(parent) == node || Right(parent) == node);
+        if (isParent)
+        {
+            return &link;
+        }
+        // a rotation moved node meanwhile
+        Unlock(link);
+    }
+    return nullptr;
+}
+
+uint64_t ConcurrentAVLTree::ReaderEnter(size_t stripe)
+{
+    while (true)
+    {
+        uint64_t e = epoch.load();
+        readers[e % 2][stripe].count.fetch_add(1);
+        if (epoch.load() == e)
+        {
+            return e;
+        }
+        // writer flipped epoch meanwhile, register in the new one
+        readers[e % 2][stripe].count.fetch_sub(1);
+    }
+}
+
+void ConcurrentAVLTree::ReaderExit(size_t stripe, uint64_t readerEpoch)
+{
+    readers[readerEpoch % 2][stripe].count.fetch_sub(1, std::memory_order_release);
+}
+
+// spread reader counters over cache lines by thread
+size_t ConcurrentAVLTree::ReaderStripe()
+{
+    static std::atomic<size_t> nextStripe{ 0 };
+    thread_local size_t stripe = nextStripe.fetch_add(1, std::memory_order_relaxed) % readerStripes;
+    return stripe;
+}
+
+void ConcurrentAVLTree::Retire(Node* node)
+{
+    std::vector<Node*> nodes;
+    {
+        std::lock_guard<std::mutex> lock(retireMutex);
+        retired.push_back(node);
+        if (retired.size() < retireThreshold)
+        {
+            return;
+        }
+        nodes.swap(retired);
+    }
+    Synchronize(nodes);
+}
+
+// wait for readers which could see nodes, then free them
+void ConcurrentAVLTree::Synchronize(std::vector<Node*>& nodes)
+{
+    std::lock_guard<std::mutex> lock(synchronizeMutex);
+    // readers of the previous epoch were drained by the previous call,
+    // new readers register in the new epoch and can't reach removed nodes
+    uint64_t e = epoch.load();
+    epoch.store(e + 1);
+    for (ReaderCount& reader : readers[e % 2])
+    {
+        while (reader.count.load() != 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+    for (Node* node : nodes)
+    {
+        delete node;
+    }
+}
+
+unsigned char ConcurrentAVLTree::Height(Node* node)
+{
+    if (node == nullptr)
+    {
+        return 0;
+    }
+    return node->height.load(std::memory_order_relaxed);
+}
+
+void ConcurrentAVLTree::FixHeight(Node* node)
+{
+    node->height.store(std::max(Height(Left(node)), Height(Right(node))) + 1, std::memory_order_relaxed);
+}
+
+int ConcurrentAVLTree::BalanceFactor(Node* node)
+{
+    return Height(Left(node)) - Height(Right(node));
+}
+
+// key ranges of p and q change, g gets a new child: all three are locked
+void ConcurrentAVLTree::RotateLeft(Node* p)
+{
+    assert(p != nullptr);
+    assert(Right(p) != nullptr);
+
+    Node* q = Right(p);
+    Node* g = p->parent.load(std::memory_order_acquire);
+
+    // p - c link
+    SetRight(p, Left(q));
+    if (Right(p) != nullptr)
+    {
+        Right(p)->parent.store(p, std::memory_order_release);
+    }
+    // q - parent link
+    q->parent.store(g, std::memory_order_release);
+    SetChild(g, p, q);
+    // p - q link
+    SetLeft(q, p);
+    p->parent.store(q, std::memory_order_release);
+
+    FixHeight(p);
+    FixHeight(q);
+}
+
+void ConcurrentAVLTree::RotateRight(Node* p)
+{
+    assert(p != nullptr);
+    assert(Left(p) != nullptr);
+
+    Node* q = Left(p);
+    Node* g = p->parent.load(std::memory_order_acquire);
+
+    // p - c link
+    SetLeft(p, Right(q));
+    if (Left(p) != nullptr)
+    {
+        Left(p)->parent.store(p, std::memory_order_release);
+    }
+    // q - parent link
+    q->parent.store(g, std::memory_order_release);
+    SetChild(g, p, q);
+    // p - q link
+    SetRight(q, p);
+    p->parent.store(q, std::memory_order_release);
+
+    FixHeight(p);
+    FixHeight(q);
+}
+
+bool ConcurrentAVLTree::NeedsFix(Node* node)
+{
+    int balance = BalanceFactor(node);
+    return balance < -1 || balance > 1 || Height(node) != std::max(Height(Left(node)), Height(Right(node))) + 1;
+}
+
+// children of node can't change while it is locked, so the child and
+// grandchild to rotate are locked after it, parent before child
+ConcurrentAVLTree::Node* ConcurrentAVLTree::FixNode(Node* node)
+{
+    int balance = BalanceFactor(node);
+    if (balance > 1)
+    {
+        Node* child = Left(node);
+        Lock(child->version);
+        if (BalanceFactor(child) >= 0)
+        {
+            RotateRight(node);
+        }
+        else
+        {
+            Node* grandchild = Right(child);
+            Lock(grandchild->version);
+            RotateLeft(child);
+            RotateRight(node);
+            Unlock(grandchild->version);
+        }
+        Unlock(child->version);
+        return node->parent.load(std::memory_order_acquire);
+    }
+    if (balance < -1)
+    {
+        Node* child = Right(node);
+        Lock(child->version);
+        if (BalanceFactor(child) <= 0)
+        {
+            RotateLeft(node);
+        }
+        else
+        {
+            Node* grandchild = Left(child);
+            Lock(grandchild->version);
+            RotateRight(child);
+            RotateLeft(node);
+            Unlock(grandchild->version);
+        }
+        Unlock(child->version);
+        return node->parent.load(std::memory_order_acquire);
+    }
+    FixHeight(node);
+    return node;
+}
+
+// go up from node fixing one node at a time, until height and balance are right;
+// heights of children are read without locks, a writer changing one of them
+// comes up here itself after that
+void ConcurrentAVLTree::Rebalance(Node* node)
+{
+    while (node != nullptr && NeedsFix(node))
+    {
+        std::atomic<uint64_t>* link = LockParent(node);
+        if (link == nullptr)
+        {
+            // node was removed, its remover rebalances from the parent
+            return;
+        }
+        Lock(node->version);
+        Node* parent = node->parent.load(std::memory_order_acquire);
+        Node* top = FixNode(node);
+        Unlock(node->version);
+        Unlock(*link);
+        // rotation with heights changing below may leave top out of balance
+        node = top != node && NeedsFix(top) ? top : parent;
+    }
+}
+
+// one optimistic descent to the node holding key, or to the node under which
+// key would be inserted, nullptr in empty tree; version is the validated version
+// of node, or of root link for nullptr
+bool ConcurrentAVLTree::FindOptimistic(int key, Node*& node, uint64_t& version, bool& found)
+{
+    uint64_t parentVersion = rootVersion.load(std::memory_order_acquire);
+    if (parentVersion % 2 != 0)
+    {
+        return false;
+    }
+    node = root.load(std::memory_order_acquire);
+    if (node == nullptr)
+    {
+        found = false;
+        version = parentVersion;
+        return rootVersion.load(std::memory_order_acquire) == parentVersion;
+    }
+    version = node->version.load(std::memory_order_acquire);
+    if (version % 2 != 0 || rootVersion.load(std::memory_order_acquire) != parentVersion)
+    {
+        return false;
+    }
+
+    while (true)
+    {
+        // node was reached through a valid link and its version was even then
+        // acquire loads keep the version check after them
+        int nodeKey = node->key.load(std::memory_order_acquire);
+        if (nodeKey == key)
+        {
+            found = true;
+            return node->version.load(std::memory_order_acquire) == version;
+        }
+        Node* child = key < nodeKey ? node->left.load(std::memory_order_acquire) : node->right.load(std::memory_order_acquire);
+        if (child == nullptr)
+        {
+            found = false;
+            return node->version.load(std::memory_order_acquire) == version;
+        }
+        // read child version before validating the link to it
+        uint64_t childVersion = child->version.load(std::memory_order_acquire);
+        if (childVersion % 2 != 0 || node->version.load(std::memory_order_acquire) != version)
+        {
+            return false;
+        }
+        node = child;
+        version = childVersion;
+    }
+}
+
+bool ConcurrentAVLTree::InsertNode(int key)
+{
+    Node* parent = nullptr;
+    uint64_t version = 0;
+    bool found = false;
+    if (!FindOptimistic(key, parent, version, found))
+    {
+        return false;
+    }
+    if (found)
+    {
+        return true;
+    }
+
+    // unchanged version means parent is still in the tree with the same
+    // key range and no child on the side of key
+    std::atomic<uint64_t>& parentVersion = LinkVersion(parent);
+    if (!TryLock(parentVersion, version))
+    {
+        return false;
+    }
+    // insert new node, it becomes visible with the link
+    Node* node = new Node(key);
+    node->parent.store(parent, std::memory_order_release);
+    if (parent == nullptr)
+    {
+        root.store(node, std::memory_order_release);
+    }
+    else if (key < parent->key.load(std::memory_order_relaxed))
+    {
+        SetLeft(parent, node);
+    }
+    else
+    {
+        SetRight(parent, node);
+    }
+    Unlock(parentVersion);
+
+    // go up and balance tree
+    Rebalance(parent);
+    return true;
+}
+
+bool ConcurrentAVLTree::RemoveNode(int key, Node*& removed)
+{
+    // find removing node
+    Node* node = nullptr;
+    uint64_t version = 0;
+    bool found = false;
+    if (!FindOptimistic(key, node, version, found))
+    {
+        return false;
+    }
+    if (!found)
+    {
+        return true;
+    }
+    if (Left(node) != nullptr && Right(node) != nullptr)
+    {
+        return RemoveWithSuccessor(node, version, removed);
+    }
+
+    // link to node, then node itself as the descent found it
+    std::atomic<uint64_t>* link = LockParent(node);
+    if (link == nullptr)
+    {
+        return false;
+    }
+    if (!TryLock(node->version, version))
+    {
+        Unlock(*link);
+        return false;
+    }
+
+    // exclude node, its only child takes its place
+    Node* parent = node->parent.load(std::memory_order_acquire);
+    Node* child = Left(node) != nullptr ? Left(node) : Right(node);
+    if (child != nullptr)
+    {
+        child->parent.store(parent, std::memory_order_release);
+    }
+    SetChild(parent, node, child);
+    node->unlinked.store(true, std::memory_order_relaxed);
+    // version of node moves on, so readers holding it restart
+    Unlock(node->version);
+    Unlock(*link);
+
+    // go up and balance tree
+    Rebalance(parent);
+    removed = node;
+    return true;
+}
+
+// key of node changes to key of its successor y, which narrows key ranges of the nodes
+// on the path from node to y: lock all of them going down, then exclude y
+bool ConcurrentAVLTree::RemoveWithSuccessor(Node* node, uint64_t version, Node*& removed)
+{
+    // node keeps both children while its version is unchanged
+    if (!TryLock(node->version, version))
+    {
+        return false;
+    }
+    Node* y = Right(node);
+    Lock(y->version);
+    while (Left(y) != nullptr)
+    {
+        y = Left(y);
+        Lock(y->version);
+    }
+
+    // exclude y
+    Node* parent = y->parent.load(std::memory_order_acquire);
+    Node* x = Right(y);
+    if (x != nullptr)
+    {
+        x->parent.store(parent, std::memory_order_release);
+    }
+    SetChild(parent, y, x);
+    node->key.store(y->key.load(std::memory_order_relaxed), std::memory_order_release);
+    y->unlinked.store(true, std::memory_order_relaxed);
+
+    Unlock(y->version);
+    for (Node* n = parent; n != node; n = n->parent.load(std::memory_order_acquire))
+    {
+        Unlock(n->version);
+    }
+    Unlock(node->version);
+
+    // go up and balance tree
+    Rebalance(parent);
+    removed = y;
+    return true;
+}
+
+void ConcurrentAVLTree::DeleteNodesRecursively(Node* node)
+{
+    if (node == nullptr)
+    {
+        return;
+    }
+    DeleteNodesRecursively(Left(node));
+    DeleteNodesRecursively(Right(node));
+    delete node;
+}
+
+void ConcurrentAVLTree::GetVector(Node* node, std::vector<int>& vec)
+{
+    if (node == nullptr)
+    {
+        return;
+    }
+    GetVector(Left(node), vec);
+    vec.push_back(node->key.load(std::memory_order_relaxed));
+    GetVector(Right(node), vec);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// AVL tree with lock-free readers and concurrent writers, after Bronson et al.
+// Every node has a version which is odd while a writer changes the node; readers go
+// down without locking and validate the version of every node they pass, restarting
+// from root if it changed. Writers go down the same way, then lock only the nodes
+// whose links they change, parent before child, and retry from root if validation
+// fails. Heights are fixed going up one node at a time, so the tree may be out of
+// balance while writers run and is an AVL tree again when they finish.
+// Removed nodes are freed after all threads that could see them finish.
+class ConcurrentAVLTree
+{
+public:
+    ConcurrentAVLTree();
+    ~ConcurrentAVLTree();
+
+    // safe to call from any number of threads
+    void Insert(int key);
+    void Remove(int key);
+    bool Find(int key);
+    // not safe to call concurrently with writers
+    std::vector<int> GetVector();
+    size_t Height();
+    // not safe to call concurrently with other methods
+    void Clear();
+
+private:
+
+    struct Node
+    {
+        std::atomic<int> key;
+        std::atomic<Node*> left;
+        std::atomic<Node*> right;
+        std::atomic<uint64_t> version;
+        // used by writers only, changed under the lock of the node or its parent
+        std::atomic<Node*> parent;
+        std::atomic<unsigned char> height;
+        // set under the lock when node leaves the tree
+        std::atomic<bool> unlinked;
+
+        Node(int key);
+    };
+
+    static const size_t readerStripes = 16;
+    static const size_t retireThreshold = 1024;
+
+    struct alignas(64) ReaderCount
+    {
+        std::atomic<size_t> count;
+    };
+
+    static Node* Left(Node* node);
+    static Node* Right(Node* node);
+    static void SetLeft(Node* node, Node* child);
+    static void SetRight(Node* node, Node* child);
+    void SetChild(Node* parent, Node* oldChild, Node* newChild);
+    static void Lock(std::atomic<uint64_t>& version);
+    // lock only if the version is still the one a descent validated
+    static bool TryLock(std::atomic<uint64_t>& version, uint64_t expected);
+    static void Unlock(std::atomic<uint64_t>& version);
+    // version of the link to children of parent, rootVersion for nullptr
+    std::atomic<uint64_t>& LinkVersion(Node* parent);
+    // lock the link to node, nullptr if node was removed
+    std::atomic<uint64_t>* LockParent(Node* node);
+
+    uint64_t ReaderEnter(size_t stripe);
+    void ReaderExit(size_t stripe, uint64_t epoch);
+    static size_t ReaderStripe();
+    void Retire(Node* node);
+    void Synchronize(std::vector<Node*>& nodes);
+
+    unsigned char Height(Node* node);
+    void FixHeight(Node* node);
+    int BalanceFactor(Node* node);
+    // callers hold locks of the link to p, p and the child rising above it
+    void RotateLeft(Node* p);
+    void RotateRight(Node* p);
+    // height or balance of node is off, read without locks
+    bool NeedsFix(Node* node);
+    // callers hold locks of the link to node and node, returns root of the fixed subtree
+    Node* FixNode(Node* node);
+    void Rebalance(Node* node);
+    // these return false if they have to be restarted from root
+    bool FindOptimistic(int key, Node*& node, uint64_t& version, bool& found);
+    bool InsertNode(int key);
+    bool RemoveNode(int key, Node*& removed);
+    bool RemoveWithSuccessor(Node* node, uint64_t version, Node*& removed);
+    void DeleteNodesRecursively(Node* node);
+    void GetVector(Node* node, std::vector<int>& vec);
+
+    std::atomic<Node*> root;
+    // version of root link
+    std::atomic<uint64_t> rootVersion;
+    std::atomic<uint64_t> epoch;
+    ReaderCount readers[2][readerStripes];
+    std::mutex retireMutex;
+    std::vector<Node*> retired;
+    // one epoch flip at a time
+    std::mutex synchronizeMutex;
+};
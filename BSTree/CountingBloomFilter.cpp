@@ -0,0 +1,127 @@
+#include "CountingBloomFilter.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iterator>
+
+CountingBloomFilter::CountingBloomFilter(size_t expectedKeys, double falsePositiveRate)
+{
+    assert(falsePositiveRate > 0.0 && falsePositiveRate < 1.0);
+
+    // optimal Bloom filter: m/n = -ln(p) / ln(2)^2 counters per key, k = ln(2) * m/n hashes
+    const double ln2 = std::log(2.0);
+    // keys are not spread evenly over blocks, which raises the rate, so aim at half of it
+    double countersPerKey = -std::log(falsePositiveRate / 2) / (ln2 * ln2);
+    size_t numCounters = static_cast<size_t>(std::ceil(countersPerKey * std::max<size_t>(expectedKeys, 1)));
+    size_t numBlocks = (numCounters + countersPerBlock - 1) / countersPerBlock;
+    numHashes = std::max(1, std::min(16, static_cast<int>(std::lround(ln2 * countersPerKey))));
+
+    blocks.resize(numBlocks);
+    Clear();
+}
+
+uint64_t CountingBloomFilter::Hash(uint64_t x)
+{
+    // splitmix64
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+CountingBloomFilter::Block& CountingBloomFilter::GetBlock(uint64_t hash)
+{
+    // high 32 bits select the block
+    return blocks[((hash >> 32) * blocks.size()) >> 32];
+}
+
+const CountingBloomFilter::Block& CountingBloomFilter::GetBlock(uint64_t hash) const
+{
+    return blocks[((hash >> 32) * blocks.size()) >> 32];
+}
+
+// Counters of a key are taken by 7 bits from a chain of hashes of the block hash.
+// Independent indices keep the rate close to a plain Bloom filter, unlike double hashing
+// which gives only a few thousand distinct patterns per block.
+unsigned int CountingBloomFilter::NextCounter(uint64_t& bits, int i)
+{
+    if (i % countersPerHash == 0)
+    {
+        bits = Hash(bits);
+    }
+    unsigned int counter = static_cast<unsigned int>(bits % countersPerBlock);
+    bits /= countersPerBlock;
+    return counter;
+}
+
+void CountingBloomFilter::Add(int key)
+{
+    uint64_t hash = Hash(static_cast<uint32_t>(key));
+    uint64_t bits = hash;
+    Block& block = GetBlock(hash);
+    for (int i = 0; i < numHashes; i++)
+    {
+        unsigned int counter = NextCounter(bits, i);
+        uint64_t& word = block.words[counter / countersPerWord];
+        unsigned int shift = (counter % countersPerWord) * 4;
+        if (((word >> shift) & counterMax) != counterMax)
+        {
+            word += uint64_t{ 1 } << shift;
+        }
+    }
+}
+
+void CountingBloomFilter::Remove(int key)
+{
+    uint64_t hash = Hash(static_cast<uint32_t>(key));
+    uint64_t bits = hash;
+    Block& block = GetBlock(hash);
+    for (int i = 0; i < numHashes; i++)
+    {
+        unsigned int counter = NextCounter(bits, i);
+        uint64_t& word = block.words[counter / countersPerWord];
+        unsigned int shift = (counter % countersPerWord) * 4;
+        uint64_t value = (word >> shift) & counterMax;
+        assert(value != 0);
+        // saturated counter has lost its exact value, keep it
+        if (value != counterMax && value != 0)
+        {
+            word -= uint64_t{ 1 } << shift;
+        }
+    }
+}
+
+bool CountingBloomFilter::MayContain(int key) const
+{
+    uint64_t hash = Hash(static_cast<uint32_t>(key));
+    uint64_t bits = hash;
+    const Block& block = GetBlock(hash);
+    for (int i = 0; i < numHashes; i++)
+    {
+        unsigned int counter = NextCounter(bits, i);
+        uint64_t word = block.words[counter / countersPerWord];
+        if (((word >> ((counter % countersPerWord) * 4)) & counterMax) == 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void CountingBloomFilter::Clear()
+{
+    for (Block& block : blocks)
+    {
+        std::fill(std::begin(block.words), std::end(block.words), 0);
+    }
+}
+
+size_t CountingBloomFilter::MemoryUsage() const
+{
+    return blocks.size() * sizeof(Block);
+}
+
+int CountingBloomFilter::NumHashes() const
+{
+    return numHashes;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Blocked counting Bloom filter: all counters of a key live in one 64-byte
+// block, so a lookup touches a single cache line. 4-bit counters allow Remove;
+// a saturated counter is never decremented, so there are no false negatives.
+class CountingBloomFilter
+{
+public:
+    CountingBloomFilter(size_t expectedKeys, double falsePositiveRate);
+
+    void Add(int key);
+    // key must have been added before
+    void Remove(int key);
+    bool MayContain(int key) const;
+    void Clear();
+    size_t MemoryUsage() const;
+    int NumHashes() const;
+
+private:
+
+    static const int countersPerBlock = 128;
+    static const int countersPerWord = 16;
+    static const uint64_t counterMax = 15;
+    static const int countersPerHash = 9;
+
+    struct alignas(64) Block
+    {
+        uint64_t words[countersPerBlock / countersPerWord];
+    };
+
+    static uint64_t Hash(uint64_t x);
+    Block& GetBlock(uint64_t hash);
+    const Block& GetBlock(uint64_t hash) const;
+    static unsigned int NextCounter(uint64_t& bits, int i);
+
+    std::vector<Block> blocks;
+    int numHashes;
+};
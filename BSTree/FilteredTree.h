@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "CountingBloomFilter.h"
+
+// Tree with a companion counting Bloom filter: Find of an absent key is
+// usually rejected by the filter without walking the tree.
+// T is any of AVLTree, AVLTreeIterative, RBTree (or anything with the same API).
+template <typename T>
+class FilteredTree
+{
+public:
+    // expectedKeys and falsePositiveRate size the filter
+    FilteredTree(size_t expectedKeys = 1'000'000, double falsePositiveRate = 0.01);
+
+    void Insert(int key);
+    void Remove(int key);
+    bool Find(int key);
+    void Clear();
+    std::vector<int> GetVector();
+    size_t MemoryUsage();
+    size_t FilterMemoryUsage() const;
+
+    size_t FilterRejects() const;
+    size_t FalsePositives() const;
+    void ResetCounters();
+
+private:
+    T tree;
+    CountingBloomFilter filter;
+    size_t rejects;
+    size_t falsePositives;
+};
+
+template <typename T>
+FilteredTree<T>::FilteredTree(size_t expectedKeys, double falsePositiveRate) :
+    filter{ expectedKeys, falsePositiveRate },
+    rejects{ 0 },
+    falsePositives{ 0 }
+{
+}
+
+template <typename T>
+void FilteredTree<T>::Insert(int key)
+{
+    // filter must count each stored key once, so skip keys already in the tree
+    if (filter.MayContain(key) && tree.Find(key))
+    {
+        return;
+    }
+    tree.Insert(key);
+    filter.Add(key);
+}
+
+template <typename T>
+void FilteredTree<T>::Remove(int key)
+{
+    if (!filter.MayContain(key) || !tree.Find(key))
+    {
+        return;
+    }
+    tree.Remove(key);
+    filter.Remove(key);
+}
+
+template <typename T>
+bool FilteredTree<T>::Find(int key)
+{
+    if (!filter.MayContain(key))
+    {
+        rejects++;
+        return false;
+    }
+    bool found = tree.Find(key);
+    if (!found)
+    {
+        falsePositives++;
+    }
+    return found;
+}
+
+template <typename T>
+void FilteredTree<T>::Clear()
+{
+    tree.Clear();
+    filter.Clear();
+}
+
+template <typename T>
+std::vector<int> FilteredTree<T>::GetVector()
+{
+    return tree.GetVector();
+}
+
+template <typename T>
+size_t FilteredTree<T>::MemoryUsage()
+{
+    return tree.MemoryUsage() + filter.MemoryUsage();
+}
+
+template <typename T>
+size_t FilteredTree<T>::FilterMemoryUsage() const
+{
+    return filter.MemoryUsage();
+}
+
+template <typename T>
+size_t FilteredTree<T>::FilterRejects() const
+{
+    return rejects;
+}
+
+template <typename T>
+size_t FilteredTree<T>::FalsePositives() const
+{
+    return falsePositives;
+}
+
+template <typename T>
+void FilteredTree<T>::ResetCounters()
+{
+    rejects = 0;
+    falsePositives = 0;
+}
@@ -0,0 +1,219 @@
+#include "HugePageAllocator.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace
+{
+#ifdef __linux__
+    // "always" or "madvise" is selected in the list, like "always [madvise] never"
+    bool TransparentHugePagesEnabled()
+    {
+        std::ifstream file("/sys/kernel/mm/transparent_hugepage/enabled");
+        std::string modes;
+        return std::getline(file, modes) && modes.find("[never]") == std::string::npos;
+    }
+#endif
+}
+
+HugePageAllocator::HugePageAllocator(size_t objectSize) :
+    objectSize{ (std::max(objectSize, sizeof(void*)) + sizeof(void*) - 1) / sizeof(void*) * sizeof(void*) },
+    freeList{ nullptr },
+    next{ nullptr },
+    end{ nullptr }
+{
+}
+
+HugePageAllocator::~HugePageAllocator()
+{
+    for (const Region& region : regions)
+    {
+        Unmap(region);
+    }
+    for (const Region& block : blocks)
+    {
+        Unmap(block);
+    }
+}
+
+void* HugePageAllocator::Allocate()
+{
+    if (freeList != nullptr)
+    {
+        void* object = freeList;
+        freeList = *static_cast<void**>(object);
+        return object;
+    }
+    if (static_cast<size_t>(end - next) < objectSize)
+    {
+        regions.push_back(Map(regionSize));
+        next = regions.back().address;
+        end = next + regions.back().size;
+    }
+    void* object = next;
+    next += objectSize;
+    return object;
+}
+
+void HugePageAllocator::Free(void* object)
+{
+    *static_cast<void**>(object) = freeList;
+    freeList = object;
+}
+
+void* HugePageAllocator::AllocateBlock(size_t count)
+{
+    blocks.push_back(Map(std::max<size_t>(count, 1) * objectSize));
+    return blocks.back().address;
+}
+
+void HugePageAllocator::FreeBlock(void* block)
+{
+    for (size_t i = 0; i < blocks.size(); i++)
+    {
+        if (blocks[i].address == block)
+        {
+            Unmap(blocks[i]);
+            blocks.erase(blocks.begin() + i);
+            return;
+        }
+    }
+}
+
+size_t HugePageAllocator::ReservedBytes() const
+{
+    size_t bytes = 0;
+    for (const Region& region : regions)
+    {
+        bytes += region.size;
+    }
+    for (const Region& block : blocks)
+    {
+        bytes += block.size;
+    }
+    return bytes;
+}
+
+size_t HugePageAllocator::HugePageBytes() const
+{
+    std::vector<const Region*> transparent;
+    size_t bytes = 0;
+    for (const std::vector<Region>* list : { &regions, &blocks })
+    {
+        for (const Region& region : *list)
+        {
+            if (region.backing == Backing::HugeTlb)
+            {
+                bytes += region.size;
+            }
+            else if (region.backing == Backing::Transparent)
+            {
+                transparent.push_back(&region);
+            }
+        }
+    }
+    if (transparent.empty())
+    {
+        return bytes;
+    }
+
+#ifdef __linux__
+    // sum AnonHugePages of mappings overlapping our regions; the kernel merges adjacent
+    // advised mappings, so one of them may also hold huge pages of another allocator
+    std::ifstream smaps("/proc/self/smaps");
+    std::string line;
+    bool inside = false;
+    while (std::getline(smaps, line))
+    {
+        size_t dash = line.find('-');
+        size_t space = line.find(' ');
+        if (dash != std::string::npos && space != std::string::npos && dash < space && line.find(':') > space)
+        {
+            // mapping header "start-end perms offset device inode path"
+            uintptr_t start = std::stoull(line.substr(0, dash), nullptr, 16);
+            uintptr_t finish = std::stoull(line.substr(dash + 1, space - dash - 1), nullptr, 16);
+            inside = std::any_of(transparent.begin(), transparent.end(), [start, finish](const Region* region)
+                {
+                    uintptr_t address = reinterpret_cast<uintptr_t>(region->address);
+                    return address < finish && start < address + region->size;
+                });
+        }
+        else if (inside && line.compare(0, 14, "AnonHugePages:") == 0)
+        {
+            std::istringstream value(line.substr(14));
+            size_t kilobytes = 0;
+            value >> kilobytes;
+            bytes += kilobytes * 1024;
+        }
+    }
+#endif
+    return bytes;
+}
+
+// size is rounded up to whole regions
+HugePageAllocator::Region HugePageAllocator::Map(size_t size)
+{
+    size = (size + regionSize - 1) / regionSize * regionSize;
+#ifdef __linux__
+    if (TransparentHugePagesEnabled())
+    {
+        // map one region more and trim both ends, so the region starts at a 2 MB boundary
+        void* base = mmap(nullptr, size + regionSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED)
+        {
+            throw std::bad_alloc();
+        }
+        char* start = static_cast<char*>(base);
+        char* address = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(start) + regionSize - 1) / regionSize * regionSize);
+        if (address > start)
+        {
+            munmap(start, address - start);
+        }
+        if (start + regionSize > address)
+        {
+            munmap(address + size, start + regionSize - address);
+        }
+        if (madvise(address, size, MADV_HUGEPAGE) == 0)
+        {
+            return Region{ address, size, Backing::Transparent, address };
+        }
+        munmap(address, size);
+    }
+    // hugetlbfs pool, empty unless vm.nr_hugepages was raised
+    void* huge = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (huge != MAP_FAILED)
+    {
+        return Region{ static_cast<char*>(huge), size, Backing::HugeTlb, huge };
+    }
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+    {
+        throw std::bad_alloc();
+    }
+    return Region{ static_cast<char*>(base), size, Backing::Normal, base };
+#else
+    void* base = std::malloc(size + regionSize);
+    if (base == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    char* address = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(base) + regionSize - 1) / regionSize * regionSize);
+    return Region{ address, size, Backing::Normal, base };
+#endif
+}
+
+void HugePageAllocator::Unmap(const Region& region)
+{
+#ifdef __linux__
+    munmap(region.address, region.size);
+#else
+    std::free(region.base);
+#endif
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Allocator of fixed size objects carved out of 2 MB aligned regions. On Linux
+// regions are advised to transparent huge pages with madvise(MADV_HUGEPAGE);
+// if the kernel refuses, they are taken from the hugetlbfs pool with
+// MAP_HUGETLB, and if that is empty too, they stay on normal pages.
+// Elsewhere regions are plain aligned heap memory.
+class HugePageAllocator
+{
+public:
+    static const size_t regionSize = size_t(2) << 20;
+
+    HugePageAllocator(size_t objectSize);
+    ~HugePageAllocator();
+    HugePageAllocator(const HugePageAllocator&) = delete;
+    HugePageAllocator& operator=(const HugePageAllocator&) = delete;
+
+    void* Allocate();
+    void Free(void* object);
+    // contiguous memory for count objects in regions of its own, returned by FreeBlock
+    void* AllocateBlock(size_t count);
+    void FreeBlock(void* block);
+    size_t ReservedBytes() const;
+    // part of reserved memory the kernel actually backs by huge pages
+    size_t HugePageBytes() const;
+
+private:
+
+    enum class Backing { Normal, Transparent, HugeTlb };
+
+    struct Region
+    {
+        char* address;
+        size_t size;
+        Backing backing;
+        // start of the mapping or heap allocation holding the region
+        void* base;
+    };
+
+    Region Map(size_t size);
+    void Unmap(const Region& region);
+
+    size_t objectSize;
+    std::vector<Region> regions;
+    std::vector<Region> blocks;
+    // freed objects, linked through their first bytes
+    void* freeList;
+    char* next;
+    char* end;
+};
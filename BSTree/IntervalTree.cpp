@@ -0,0 +1,204 @@
+#include "IntervalTree.h"
+#include <cassert>
+#include <algorithm>
+
+IntervalTree::IntervalTree()
+{
+}
+
+IntervalTree::~IntervalTree()
+{
+    DeleteNodesRecursively(root);
+}
+
+IntervalTree::Node* IntervalTree::NewNode(int lo, int hi)
+{
+    Node* node = new Node;
+    node->lo = lo;
+    node->hi = hi;
+    node->max = hi;
+    return node;
+}
+
+void IntervalTree::DeleteNode(Node* node)
+{
+    delete node;
+}
+
+void IntervalTree::DeleteNodesRecursively(Node* node)
+{
+    if (node == nil)
+    {
+        return;
+    }
+    DeleteNodesRecursively(node->left);
+    DeleteNodesRecursively(node->right);
+    DeleteNode(node);
+}
+
+bool IntervalTree::Less(int lo1, int hi1, int lo2, int hi2)
+{
+    return lo1 < lo2 || (lo1 == lo2 && hi1 < hi2);
+}
+
+void IntervalTree::Insert(int lo, int hi)
+{
+    assert(lo <= hi);
+    InsertNode(lo, hi);
+}
+
+void IntervalTree::InsertNode(int lo, int hi)
+{
+    Node* parent = nil;
+    Node* node = root;
+
+    // find insertion position
+    while (node != nil)
+    {
+        if (lo == node->lo && hi == node->hi)
+        {
+            return;
+        }
+
+        parent = node;
+        if (Less(lo, hi, node->lo, node->hi))
+        {
+            node = node->left;
+        }
+        else
+        {
+            node = node->right;
+        }
+    }
+
+    // insert, new interval may raise max of all ancestors
+    node = NewNode(lo, hi);
+    InsertLeaf(node, parent, parent != nil && Less(lo, hi, parent->lo, parent->hi));
+}
+
+IntervalTree::Node* IntervalTree::FindNode(int lo, int hi)
+{
+    Node* node = root;
+    while (node != nil)
+    {
+        if (node->lo == lo && node->hi == hi)
+        {
+            return node;
+        }
+        if (Less(lo, hi, node->lo, node->hi))
+        {
+            node = node->left;
+        }
+        else
+        {
+            node = node->right;
+        }
+    }
+    return nil;
+}
+
+void IntervalTree::Remove(int lo, int hi)
+{
+    RemoveNode(lo, hi);
+}
+
+void IntervalTree::RemoveNode(int lo, int hi)
+{
+    Node* node = FindNode(lo, hi);
+    if (node == nil)
+    {
+        return;
+    }
+    DeleteNode(Unlink(node));
+}
+
+bool IntervalTree::Find(int lo, int hi)
+{
+    return FindNode(lo, hi) != nil;
+}
+
+void IntervalTree::FindOverlapping(int lo, int hi, const std::function<void(int, int)>& callback)
+{
+    FindOverlapping(root, lo, hi, callback);
+}
+
+void IntervalTree::FindOverlapping(Node* node, int lo, int hi, const std::function<void(int, int)>& callback)
+{
+    // nothing in subtree ends at or after lo
+    if (node == nil || node->max < lo)
+    {
+        return;
+    }
+    FindOverlapping(node->left, lo, hi, callback);
+    // node and all its right subtree start after hi
+    if (node->lo > hi)
+    {
+        return;
+    }
+    if (node->hi >= lo)
+    {
+        callback(node->lo, node->hi);
+    }
+    FindOverlapping(node->right, lo, hi, callback);
+}
+
+bool IntervalTree::AnyOverlap(int lo, int hi)
+{
+    Node* node = root;
+    while (node != nil)
+    {
+        if (node->lo <= hi && lo <= node->hi)
+        {
+            return true;
+        }
+        // if left subtree has no overlap, right subtree doesn't have it either
+        if (node->left->max >= lo)
+        {
+            node = node->left;
+        }
+        else
+        {
+            node = node->right;
+        }
+    }
+    return false;
+}
+
+void IntervalTree::Clear()
+{
+    DeleteNodesRecursively(root);
+    root = nil;
+}
+
+void IntervalTree::GetVector(Node* node, std::vector<std::pair<int, int>>& vec)
+{
+    if (node == nil)
+    {
+        return;
+    }
+    GetVector(node->left, vec);
+    vec.emplace_back(node->lo, node->hi);
+    GetVector(node->right, vec);
+}
+
+std::vector<std::pair<int, int>> IntervalTree::GetVector()
+{
+    std::vector<std::pair<int, int>> values;
+    GetVector(root, values);
+    return values;
+}
+
+size_t IntervalTree::Height()
+{
+    return Height(root);
+}
+
+size_t IntervalTree::Height(Node* node)
+{
+    if (node == nil)
+    {
+        return 0;
+    }
+
+    return std::max(Height(node->left), Height(node->right)) + 1;
+}
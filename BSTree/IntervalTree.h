@@ -0,0 +1,65 @@
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+#include "RBTreeBase.h"
+
+// interval of an IntervalTree node and max endpoint of its subtree,
+// INT_MIN in nil so it never raises max of its parent
+struct IntervalTreeEntry
+{
+    int lo;
+    int hi;
+    int max = INT_MIN;
+};
+
+// keeps max of IntervalTreeEntry
+struct MaxEndpoint
+{
+    static const bool enabled = true;
+
+    template <typename Node>
+    static void Update(Node* node)
+    {
+        node->max = std::max(node->hi, std::max(node->left->max, node->right->max));
+    }
+};
+
+// Red-black tree of closed intervals [lo, hi] ordered by (lo, hi).
+// Every node keeps max endpoint of its subtree, updated in rotations and fixups,
+// which lets overlap queries skip subtrees ending before the query.
+class IntervalTree : private RBTreeBase<IntervalTreeEntry, MaxEndpoint>
+{
+public:
+    IntervalTree();
+    ~IntervalTree();
+
+    void Insert(int lo, int hi);
+    void Remove(int lo, int hi);
+    bool Find(int lo, int hi);
+    // calls callback(lo, hi) for every stored interval overlapping [lo, hi], in order
+    void FindOverlapping(int lo, int hi, const std::function<void(int, int)>& callback);
+    bool AnyOverlap(int lo, int hi);
+    void Clear();
+    std::vector<std::pair<int, int>> GetVector();
+    size_t Height();
+
+private:
+
+    Node* NewNode(int lo, int hi);
+    void DeleteNode(Node* node);
+    void DeleteNodesRecursively(Node* node);
+
+    static bool Less(int lo1, int hi1, int lo2, int hi2);
+    void InsertNode(int lo, int hi);
+    Node* FindNode(int lo, int hi);
+    void RemoveNode(int lo, int hi);
+    void FindOverlapping(Node* node, int lo, int hi, const std::function<void(int, int)>& callback);
+
+    void GetVector(Node* node, std::vector<std::pair<int, int>>& vec);
+    size_t Height(Node* node);
+};
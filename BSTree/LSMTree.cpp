@@ -0,0 +1,316 @@
+#include "LSMTree.h"
+#include <algorithm>
+#include <cassert>
+
+int LSMTree::Run::Find(int key) const
+{
+    if (keys.empty() || key < keys.front() || key > keys.back())
+    {
+        return 0;
+    }
+    size_t block = std::upper_bound(fences.cbegin(), fences.cend(), key) - fences.cbegin() - 1;
+    auto first = keys.cbegin() + block * fenceStride;
+    auto last = keys.cbegin() + std::min((block + 1) * fenceStride, keys.size());
+    auto found = std::lower_bound(first, last, key);
+    if (found == last || *found != key)
+    {
+        return 0;
+    }
+    return removed[found - keys.cbegin()] ? -1 : 1;
+}
+
+void LSMTree::Run::BuildFences()
+{
+    fences.clear();
+    for (size_t i = 0; i < keys.size(); i += fenceStride)
+    {
+        fences.push_back(keys[i]);
+    }
+}
+
+LSMTree::LSMTree(size_t memtableSize, size_t fanout) :
+    memtableSize{ memtableSize },
+    fanout{ fanout },
+    memtableOps{ 0 },
+    mergeDone{ false },
+    mergeLevel{ 0 }
+{
+    assert(memtableSize > 0 && fanout >= 2);
+}
+
+LSMTree::~LSMTree()
+{
+    JoinMerge();
+}
+
+void LSMTree::Insert(int key)
+{
+    if (mergeDone.load(std::memory_order_acquire))
+    {
+        InstallMerge();
+    }
+    memtableRemoved.Remove(key);
+    memtable.Insert(key);
+    if (++memtableOps >= memtableSize)
+    {
+        Freeze();
+    }
+}
+
+void LSMTree::Remove(int key)
+{
+    if (mergeDone.load(std::memory_order_acquire))
+    {
+        InstallMerge();
+    }
+    memtable.Remove(key);
+    // without runs there is nothing for a tombstone to hide
+    if (!levels.empty())
+    {
+        memtableRemoved.Insert(key);
+    }
+    if (++memtableOps >= memtableSize)
+    {
+        Freeze();
+    }
+}
+
+bool LSMTree::Find(int key)
+{
+    if (mergeDone.load(std::memory_order_acquire))
+    {
+        InstallMerge();
+    }
+    if (memtable.Find(key))
+    {
+        return true;
+    }
+    if (memtableRemoved.Find(key))
+    {
+        return false;
+    }
+    for (const std::vector<std::shared_ptr<const Run>>& level : levels)
+    {
+        for (auto run = level.crbegin(); run != level.crend(); ++run)
+        {
+            int found = (*run)->Find(key);
+            if (found != 0)
+            {
+                return found > 0;
+            }
+        }
+    }
+    return false;
+}
+
+void LSMTree::Clear()
+{
+    JoinMerge();
+    memtable.Clear();
+    memtableRemoved.Clear();
+    memtableOps = 0;
+    levels.clear();
+}
+
+std::vector<int> LSMTree::GetVector()
+{
+    // apply runs from the oldest one, so no tombstone is needed on the way
+    std::shared_ptr<Run> all = std::make_shared<Run>();
+    for (auto level = levels.crbegin(); level != levels.crend(); ++level)
+    {
+        for (const std::shared_ptr<const Run>& run : *level)
+        {
+            all = MergeRuns(*all, *run, true);
+        }
+    }
+    Run newest;
+    newest.keys = memtable.GetVector();
+    newest.removed.assign(newest.keys.size(), false);
+    all = MergeRuns(*all, newest, true);
+    newest.keys = memtableRemoved.GetVector();
+    newest.removed.assign(newest.keys.size(), true);
+    all = MergeRuns(*all, newest, true);
+    return all->keys;
+}
+
+size_t LSMTree::MemoryUsage()
+{
+    size_t bytes = memtable.MemoryUsage() + memtableRemoved.MemoryUsage();
+    for (const std::vector<std::shared_ptr<const Run>>& level : levels)
+    {
+        for (const std::shared_ptr<const Run>& run : level)
+        {
+            bytes += sizeof(Run) + run->keys.capacity() * sizeof(int) + run->removed.capacity() / 8 + run->fences.capacity() * sizeof(int);
+        }
+    }
+    return bytes;
+}
+
+size_t LSMTree::RunCount()
+{
+    size_t count = 0;
+    for (const std::vector<std::shared_ptr<const Run>>& level : levels)
+    {
+        count += level.size();
+    }
+    return count;
+}
+
+std::shared_ptr<LSMTree::Run> LSMTree::MergeRuns(const Run& older, const Run& newer, bool dropTombstones)
+{
+    std::shared_ptr<Run> merged = std::make_shared<Run>();
+    merged->keys.reserve(older.keys.size() + newer.keys.size());
+    merged->removed.reserve(older.keys.size() + newer.keys.size());
+    size_t i = 0;
+    size_t j = 0;
+    while (i < older.keys.size() || j < newer.keys.size())
+    {
+        int key;
+        bool removed;
+        if (j == newer.keys.size() || (i < older.keys.size() && older.keys[i] < newer.keys[j]))
+        {
+            key = older.keys[i];
+            removed = older.removed[i];
+            i++;
+        }
+        else
+        {
+            // equal keys: the newer entry wins
+            if (i < older.keys.size() && older.keys[i] == newer.keys[j])
+            {
+                i++;
+            }
+            key = newer.keys[j];
+            removed = newer.removed[j];
+            j++;
+        }
+        if (removed && dropTombstones)
+        {
+            continue;
+        }
+        merged->keys.push_back(key);
+        merged->removed.push_back(removed);
+    }
+    merged->BuildFences();
+    return merged;
+}
+
+void LSMTree::Freeze()
+{
+    std::vector<int> keys = memtable.GetVector();
+    std::vector<int> removedKeys = memtableRemoved.GetVector();
+    memtable.Clear();
+    memtableRemoved.Clear();
+    memtableOps = 0;
+    if (keys.empty() && removedKeys.empty())
+    {
+        return;
+    }
+
+    // the two memtables have disjoint keys
+    std::shared_ptr<Run> run = std::make_shared<Run>();
+    run->keys.reserve(keys.size() + removedKeys.size());
+    run->removed.reserve(keys.size() + removedKeys.size());
+    size_t i = 0;
+    size_t j = 0;
+    while (i < keys.size() || j < removedKeys.size())
+    {
+        if (j == removedKeys.size() || (i < keys.size() && keys[i] < removedKeys[j]))
+        {
+            run->keys.push_back(keys[i++]);
+            run->removed.push_back(false);
+        }
+        else
+        {
+            run->keys.push_back(removedKeys[j++]);
+            run->removed.push_back(true);
+        }
+    }
+    run->BuildFences();
+
+    if (levels.empty())
+    {
+        levels.emplace_back();
+    }
+    levels[0].push_back(run);
+    StartMerge();
+    // writes stall while merges fall behind, so Find doesn't check ever more runs
+    while (merger.joinable() && levels[0].size() >= 2 * fanout)
+    {
+        InstallMerge();
+    }
+}
+
+// merges the oldest fanout runs of the level with most runs into one run of the next level;
+// the first full level would always be level 0 while writes go on, starving the others
+void LSMTree::StartMerge()
+{
+    if (merger.joinable() || levels.empty())
+    {
+        return;
+    }
+    size_t level = 0;
+    for (size_t i = 1; i < levels.size(); i++)
+    {
+        if (levels[i].size() > levels[level].size())
+        {
+            level = i;
+        }
+    }
+    if (levels[level].size() < fanout)
+    {
+        return;
+    }
+
+    // tombstones are only needed while older runs are below
+    bool dropTombstones = true;
+    for (size_t below = level + 1; below < levels.size(); below++)
+    {
+        dropTombstones = dropTombstones && levels[below].empty();
+    }
+    std::vector<std::shared_ptr<const Run>> inputs(levels[level].begin(), levels[level].begin() + fanout);
+    mergeLevel = level;
+    merger = std::thread([this, inputs, dropTombstones]()
+    {
+        std::shared_ptr<Run> merged = MergeRuns(*inputs[0], *inputs[1], dropTombstones);
+        for (size_t i = 2; i < inputs.size(); i++)
+        {
+            merged = MergeRuns(*merged, *inputs[i], dropTombstones);
+        }
+        mergeResult = merged;
+        mergeDone.store(true, std::memory_order_release);
+    });
+}
+
+// inputs stay in their level until the result replaces them, so Find sees every key meanwhile
+void LSMTree::InstallMerge()
+{
+    merger.join();
+    mergeDone.store(false, std::memory_order_relaxed);
+    std::vector<std::shared_ptr<const Run>>& inputs = levels[mergeLevel];
+    inputs.erase(inputs.begin(), inputs.begin() + fanout);
+    if (mergeLevel + 1 == levels.size())
+    {
+        levels.emplace_back();
+    }
+    if (!mergeResult->keys.empty())
+    {
+        levels[mergeLevel + 1].push_back(std::move(mergeResult));
+    }
+    mergeResult.reset();
+    while (!levels.empty() && levels.back().empty())
+    {
+        levels.pop_back();
+    }
+    StartMerge();
+}
+
+void LSMTree::JoinMerge()
+{
+    if (merger.joinable())
+    {
+        merger.join();
+    }
+    mergeDone.store(false, std::memory_order_relaxed);
+    mergeResult.reset();
+}
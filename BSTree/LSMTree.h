@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "RBTree.h"
+
+// Log-structured merge set. Updates go to a small RBTree memtable, a full
+// memtable is frozen into an immutable sorted run. Runs are merged with a
+// tiered policy: fanout runs of a level become one run of the next level.
+// Merges run on a background thread from immutable inputs, the result
+// replaces them at the next operation after it is ready, so Find never waits
+// for a merge; only a freeze waits once level 0 has 2 * fanout runs. Find
+// checks the memtable, then runs from newest to oldest; the first one having
+// the key decides.
+class LSMTree
+{
+public:
+
+    LSMTree(size_t memtableSize = 4096, size_t fanout = 4);
+    ~LSMTree();
+    void Insert(int key);
+    void Remove(int key);
+    bool Find(int key);
+    void Clear();
+    std::vector<int> GetVector();
+    size_t MemoryUsage();
+    // number of sorted runs a missing key is looked up in
+    size_t RunCount();
+
+private:
+
+    // keys in a block of fenceStride keys are found by binary search after the fence pointers
+    static const size_t fenceStride = 64;
+
+    struct Run
+    {
+        std::vector<int> keys;
+        // removed[i] is a tombstone hiding keys[i] in older runs
+        std::vector<bool> removed;
+        // first key of every block
+        std::vector<int> fences;
+
+        // 1 if found, -1 if removed, 0 if the run knows nothing about key
+        int Find(int key) const;
+        void BuildFences();
+    };
+
+    // keys of newer win, tombstones are dropped if nothing older is left below
+    static std::shared_ptr<Run> MergeRuns(const Run& older, const Run& newer, bool dropTombstones);
+    void Freeze();
+    void StartMerge();
+    // replaces the inputs of a finished merge with its result, starts the next merge
+    void InstallMerge();
+    // waits for a running merge and drops its result
+    void JoinMerge();
+
+    size_t memtableSize;
+    size_t fanout;
+    RBTree memtable;
+    // tombstones of the memtable
+    RBTree memtableRemoved;
+    size_t memtableOps;
+    // levels[i] from oldest to newest run, every run of level i is newer than any of level i + 1
+    std::vector<std::vector<std::shared_ptr<const Run>>> levels;
+
+    std::thread merger;
+    std::atomic<bool> mergeDone;
+    size_t mergeLevel;
+    std::shared_ptr<Run> mergeResult;
+};
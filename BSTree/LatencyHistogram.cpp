@@ -0,0 +1,101 @@
+#include "LatencyHistogram.h"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+
+LatencyHistogram::LatencyHistogram() :
+    buckets(bucketCount, 0),
+    count{ 0 },
+    max{ 0 }
+{
+}
+
+double LatencyHistogram::TickNanoseconds()
+{
+#ifdef LATENCY_RDTSC
+    static const double tick = []()
+    {
+        // spin for 10 ms, long enough to hide the cost of reading both clocks
+        auto start = std::chrono::steady_clock::now();
+        uint64_t startTicks = Now();
+        auto end = start;
+        while (end - start < std::chrono::milliseconds(10))
+        {
+            end = std::chrono::steady_clock::now();
+        }
+        uint64_t ticks = Now() - startTicks;
+        return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(ticks);
+    }();
+    return tick;
+#else
+    return 1.0;
+#endif
+}
+
+void LatencyHistogram::Record(uint64_t ticks)
+{
+    buckets[BucketIndex(ticks)]++;
+    count++;
+    max = std::max(max, ticks);
+}
+
+size_t LatencyHistogram::Count() const
+{
+    return count;
+}
+
+double LatencyHistogram::Percentile(double percent) const
+{
+    if (count == 0)
+    {
+        return 0.0;
+    }
+    // rank of the value, counting from 1
+    size_t rank = static_cast<size_t>(std::ceil(percent / 100.0 * static_cast<double>(count)));
+    rank = std::clamp<size_t>(rank, 1, count);
+    size_t seen = 0;
+    size_t index = 0;
+    while (seen + buckets[index] < rank)
+    {
+        seen += buckets[index];
+        index++;
+    }
+    return static_cast<double>(std::min(BucketTop(index), max)) * TickNanoseconds();
+}
+
+double LatencyHistogram::Max() const
+{
+    return static_cast<double>(max) * TickNanoseconds();
+}
+
+void LatencyHistogram::Clear()
+{
+    std::fill(buckets.begin(), buckets.end(), 0);
+    count = 0;
+    max = 0;
+}
+
+size_t LatencyHistogram::BucketIndex(uint64_t ticks)
+{
+    if (ticks < linearBuckets)
+    {
+        return static_cast<size_t>(ticks);
+    }
+    // top bit is 6 or more, the next 5 bits pick the sub-bucket
+    size_t topBit = std::bit_width(ticks) - 1;
+    size_t shift = topBit - 5;
+    return linearBuckets + (topBit - 6) * subBuckets + static_cast<size_t>((ticks >> shift) - subBuckets);
+}
+
+uint64_t LatencyHistogram::BucketTop(size_t index)
+{
+    if (index < linearBuckets)
+    {
+        return index;
+    }
+    size_t topBit = (index - linearBuckets) / subBuckets + 6;
+    size_t shift = topBit - 5;
+    uint64_t bottom = static_cast<uint64_t>(subBuckets + (index - linearBuckets) % subBuckets) << shift;
+    return bottom + ((uint64_t(1) << shift) - 1);
+}
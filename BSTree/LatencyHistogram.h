@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#define LATENCY_RDTSC
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <x86intrin.h>
+#define LATENCY_RDTSC
+#else
+#include <chrono>
+#endif
+
+// Histogram of latencies in clock ticks with log-linear buckets: values below 64
+// have a bucket each, above that every power of two is split into 32 buckets,
+// so a percentile is off by at most 1/32 while the whole 64-bit range fits.
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    // time stamp in ticks: rdtsc on x86, steady_clock nanoseconds elsewhere
+    static uint64_t Now()
+    {
+#ifdef LATENCY_RDTSC
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+    // length of a tick, measured against steady_clock on first call
+    static double TickNanoseconds();
+
+    void Record(uint64_t ticks);
+    size_t Count() const;
+    // latency in ns that percent of recorded values don't exceed, 0 if nothing is recorded
+    double Percentile(double percent) const;
+    double Max() const;
+    void Clear();
+
+private:
+    static const size_t linearBuckets = 64;
+    static const size_t subBuckets = 32;
+    static const size_t bucketCount = linearBuckets + (64 - 6) * subBuckets;
+
+    static size_t BucketIndex(uint64_t ticks);
+    // largest value falling into bucket index
+    static uint64_t BucketTop(size_t index);
+
+    std::vector<uint64_t> buckets;
+    size_t count;
+    uint64_t max;
+};
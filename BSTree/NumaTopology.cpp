@@ -0,0 +1,80 @@
+#include "NumaTopology.h"
+#include <fstream>
+#include <sstream>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+NumaTopology::NumaTopology()
+{
+#ifdef __linux__
+    // node directories are numbered densely on almost all machines, stop at the first gap
+    for (size_t node = 0; ; node++)
+    {
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string list;
+        if (!file || !std::getline(file, list))
+        {
+            break;
+        }
+        nodeCpus.push_back(ParseCpuList(list));
+        for (int cpu : nodeCpus.back())
+        {
+            if (cpuNode.size() <= static_cast<size_t>(cpu))
+            {
+                cpuNode.resize(cpu + 1, 0);
+            }
+            cpuNode[cpu] = node;
+        }
+    }
+#endif
+    if (nodeCpus.empty())
+    {
+        nodeCpus.emplace_back();
+    }
+}
+
+size_t NumaTopology::NumNodes() const
+{
+    return nodeCpus.size();
+}
+
+size_t NumaTopology::CurrentNode() const
+{
+#ifdef __linux__
+    int cpu = sched_getcpu();
+    if (cpu >= 0 && static_cast<size_t>(cpu) < cpuNode.size())
+    {
+        return cpuNode[cpu];
+    }
+#endif
+    return 0;
+}
+
+const std::vector<int>& NumaTopology::Cpus(size_t node) const
+{
+    return nodeCpus[node];
+}
+
+// "0-3,8,10-11" -> 0 1 2 3 8 10 11
+std::vector<int> NumaTopology::ParseCpuList(const std::string& list)
+{
+    std::vector<int> cpus;
+    std::stringstream stream(list);
+    std::string range;
+    while (std::getline(stream, range, ','))
+    {
+        if (range.empty())
+        {
+            continue;
+        }
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; cpu++)
+        {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
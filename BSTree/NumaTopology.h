@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// NUMA nodes and their CPUs, read from /sys/devices/system/node on Linux.
+// Elsewhere, or if sysfs is not available, the machine is one node.
+class NumaTopology
+{
+public:
+    NumaTopology();
+
+    size_t NumNodes() const;
+    // node of the CPU the calling thread runs on
+    size_t CurrentNode() const;
+    const std::vector<int>& Cpus(size_t node) const;
+
+private:
+    static std::vector<int> ParseCpuList(const std::string& list);
+
+    std::vector<std::vector<int>> nodeCpus;
+    std::vector<size_t> cpuNode;
+};
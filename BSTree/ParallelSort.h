@@ -0,0 +1,73 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// 0 means one thread per hardware thread
+inline unsigned int BuildThreads(unsigned int threads)
+{
+    if (threads == 0)
+    {
+        threads = std::thread::hardware_concurrency();
+    }
+    return std::max(threads, 1u);
+}
+
+// every thread sorts its chunk, then neighbouring chunks are merged in
+// parallel, halving the number of chunks every round
+inline void ParallelSort(std::vector<int>& keys, unsigned int threads)
+{
+    size_t chunks = std::min<size_t>(BuildThreads(threads), std::max<size_t>(keys.size() / 4096, 1));
+    std::vector<size_t> bounds;
+    for (size_t i = 0; i <= chunks; i++)
+    {
+        bounds.push_back(keys.size() * i / chunks);
+    }
+
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < chunks; i++)
+    {
+        workers.emplace_back([&keys, &bounds, i]() { std::sort(keys.begin() + bounds[i], keys.begin() + bounds[i + 1]); });
+    }
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+
+    for (size_t width = 1; width < chunks; width *= 2)
+    {
+        workers.clear();
+        for (size_t i = 0; i + width < chunks; i += 2 * width)
+        {
+            size_t last = std::min(i + 2 * width, chunks);
+            workers.emplace_back([&keys, &bounds, i, width, last]()
+                {
+                    std::inplace_merge(keys.begin() + bounds[i], keys.begin() + bounds[i + width], keys.begin() + bounds[last]);
+                });
+        }
+        for (std::thread& worker : workers)
+        {
+            worker.join();
+        }
+    }
+}
+
+// collapse runs of equal sorted keys to one key, counts[i] gets the length of run of keys[i]
+inline void CountRuns(std::vector<int>& keys, std::vector<unsigned int>& counts)
+{
+    counts.clear();
+    size_t size = 0;
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        if (size > 0 && keys[size - 1] == keys[i])
+        {
+            counts[size - 1]++;
+            continue;
+        }
+        keys[size++] = keys[i];
+        counts.push_back(1);
+    }
+    keys.resize(size);
+}
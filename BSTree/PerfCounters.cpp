@@ -0,0 +1,125 @@
+#include "PerfCounters.h"
+#include <cstdint>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#ifdef __linux__
+    // type and config of every Event
+    const uint32_t eventTypes[PerfCounters::eventCount] =
+    {
+        PERF_TYPE_HARDWARE,
+        PERF_TYPE_HARDWARE,
+        PERF_TYPE_HW_CACHE,
+        PERF_TYPE_HW_CACHE,
+        PERF_TYPE_HW_CACHE,
+        PERF_TYPE_HARDWARE
+    };
+    const uint64_t eventConfigs[PerfCounters::eventCount] =
+    {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+        PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+        PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+        PERF_COUNT_HW_BRANCH_MISSES
+    };
+
+    int OpenEvent(uint32_t type, uint64_t config)
+    {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+}
+
+PerfCounters::PerfCounters()
+{
+    for (size_t i = 0; i < eventCount; i++)
+    {
+#ifdef __linux__
+        fds[i] = OpenEvent(eventTypes[i], eventConfigs[i]);
+#else
+        fds[i] = -1;
+#endif
+        counts[i] = -1.0;
+    }
+}
+
+PerfCounters::~PerfCounters()
+{
+#ifdef __linux__
+    for (int fd : fds)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+#endif
+}
+
+void PerfCounters::Start()
+{
+#ifdef __linux__
+    for (int fd : fds)
+    {
+        if (fd >= 0)
+        {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+void PerfCounters::Stop()
+{
+#ifdef __linux__
+    for (int fd : fds)
+    {
+        if (fd >= 0)
+        {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+    for (size_t i = 0; i < eventCount; i++)
+    {
+        // value, time enabled, time running
+        uint64_t values[3];
+        counts[i] = -1.0;
+        if (fds[i] >= 0 && read(fds[i], values, sizeof(values)) == static_cast<ssize_t>(sizeof(values)) && values[2] > 0)
+        {
+            counts[i] = static_cast<double>(values[0]) * static_cast<double>(values[1]) / static_cast<double>(values[2]);
+        }
+    }
+#endif
+}
+
+bool PerfCounters::Available(Event event) const
+{
+    return counts[static_cast<size_t>(event)] >= 0.0;
+}
+
+double PerfCounters::Count(Event event) const
+{
+    return counts[static_cast<size_t>(event)];
+}
+
+const char* PerfCounters::Name(Event event)
+{
+    static const char* names[eventCount] = { "cycles", "instr", "L1 miss", "LLC miss", "dTLB miss", "br miss" };
+    return names[static_cast<size_t>(event)];
+}
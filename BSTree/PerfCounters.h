@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+
+// Hardware counters of the calling thread around a phase of work, user space only.
+// On Linux they are read with perf_event_open; events the CPU, kernel
+// (perf_event_paranoid) or a virtual machine doesn't allow stay unavailable,
+// and everything is unavailable elsewhere. Events are opened separately, so when
+// there are more of them than hardware counters the kernel time-shares them and
+// counts are scaled up from the time each was running.
+class PerfCounters
+{
+public:
+    enum class Event { Cycles, Instructions, L1Misses, LLCMisses, DTLBMisses, BranchMisses };
+    static const size_t eventCount = 6;
+
+    PerfCounters();
+    ~PerfCounters();
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    void Start();
+    void Stop();
+    // whether event was counted between the last Start and Stop
+    bool Available(Event event) const;
+    double Count(Event event) const;
+    // short column label of event
+    static const char* Name(Event event);
+
+private:
+    int fds[eventCount];
+    // negative while not counted
+    double counts[eventCount];
+};
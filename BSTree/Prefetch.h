@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <xmmintrin.h>
+#endif
+
+// hint to bring the cache line of address in, never faults
+inline void Prefetch(const void* address)
+{
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+    _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#elif defined(__GNUC__)
+    __builtin_prefetch(address);
+#else
+    (void)address;
+#endif
+}
+
+// Find of every key in a binary search tree of Node (with key, left and right), empty is
+// nullptr or the tree's sentinel. Descents of a group of keys are interleaved: each step
+// advances every lookup by one level and prefetches its next node, so cache misses overlap.
+template <typename Node>
+void FindInterleaved(Node* root, const std::type_identity_t<Node>* empty, const std::vector<int>& keys, std::vector<bool>& found)
+{
+    const size_t groupSize = 16;
+    Node* nodes[groupSize];
+    size_t indices[groupSize];
+    size_t active = 0;
+    size_t next = 0;
+    found.assign(keys.size(), false);
+    while (active < groupSize && next < keys.size())
+    {
+        nodes[active] = root;
+        indices[active] = next;
+        active++;
+        next++;
+    }
+    while (active > 0)
+    {
+        size_t i = 0;
+        while (i < active)
+        {
+            Node* node = nodes[i];
+            int key = keys[indices[i]];
+            if (node == empty || node->key == key)
+            {
+                found[indices[i]] = node != empty;
+                // start next key in this slot or close the slot
+                if (next < keys.size())
+                {
+                    nodes[i] = root;
+                    indices[i] = next;
+                    next++;
+                    i++;
+                }
+                else
+                {
+                    active--;
+                    nodes[i] = nodes[active];
+                    indices[i] = indices[active];
+                }
+                continue;
+            }
+            node = key < node->key ? node->left : node->right;
+            Prefetch(node);
+            nodes[i] = node;
+            i++;
+        }
+    }
+}
@@ -1,486 +1,921 @@
-#include "RBTree.h"
-#include <cassert>
-#include <algorithm>
-
-RBTree::Node::Node() :
-    left{ nullptr },
-    right{ nullptr },
-    parent{ nullptr },
-    color{ Color::Red },
-    key{ 0 }
-{
-}
-
-RBTree::Node::Node(int key) :
-    left{ nullptr },
-    right{ nullptr },
-    parent{ nullptr },
-    color{ Color::Red },
-    key{ key }
-{
-}
-
-RBTree::RBTree()
-{
-    nil->key = 0;
-    nil->color = Color::Black;
-    nil->left = nullptr;
-    nil->right = nullptr;
-    nil->parent = nullptr;
-}
-
-RBTree::~RBTree()
-{
-    DeleteNodesRecursively(root);
-}
-
-RBTree::Node* RBTree::NewNode(int key)
-{
-    Node* node = new Node;
-    node->key = key;
-    node->color = Color::Red;
-    node->left = nil;
-    node->right = nil;
-    node->parent = nil;
-    return node;
-}
-
-void RBTree::DeleteNode(Node* node)
-{
-    delete node;
-}
-
-void RBTree::DeleteNodesRecursively(Node* node)
-{
-    if (node == nil)
-    {
-        return;
-    }
-    DeleteNodesRecursively(node->left);
-    DeleteNodesRecursively(node->right);
-    DeleteNode(node);
-}
-
-void RBTree::RotateLeft(Node* p)
-{
-    assert(p != nil);
-    assert(p->right != nil);
-    assert(root->parent == nil);
-
-    Node* q = p->right;
-
-    // p - c link
-    p->right = q->left;
-    if (p->right != nil)
-    {
-        p->right->parent = p;
-    }
-    // q - parent link
-    q->parent = p->parent;
-    if (q->parent == nil)
-    {
-        root = q;
-        assert(root->parent == nil);
-    }
-    else
-    {
-        if (p == p->parent->left)
-        {
-            q->parent->left = q;
-        }
-        else
-        {
-            q->parent->right = q;
-        }
-    }
-    // p - q link
-    q->left = p;
-    p->parent = q;
-}
-
-void RBTree::RotateRight(Node* p)
-{
-    assert(p != nil);
-    assert(p->left != nil);
-    assert(root->parent == nil);
-
-    Node* q = p->left;
-
-    // p - c link
-    p->left = q->right;
-    if (p->left != nil)
-    {
-        p->left->parent = p;
-    }
-    // q - parent link
-    q->parent = p->parent;
-    if (q->parent == nil)
-    {
-        root = q;
-        assert(root->parent == nil);
-    }
-    else
-    {
-        if (p == p->parent->left)
-        {
-            q->parent->left = q;
-        }
-        else
-        {
-            q->parent->right = q;
-        }
-    }
-    // p - q link
-    q->right = p;
-    p->parent = q;
-}
-
-void RBTree::Insert(int key)
-{
-    Node* node = InsertNode(key);
-    if (node == nullptr)
-    {
-        return;
-    }
-    InsertFixup(node);
-}
-
-RBTree::Node* RBTree::InsertNode(int key)
-{
-    Node* parent = nil;
-    Node* node = root;
-
-    // find insertion position
-    while (node != nil)
-    {
-        if (key == node->key)
-        {
-            return nullptr;
-        }
-
-        parent = node;
-        if (key < node->key)
-        {
-            node = node->left;
-        }
-        else
-        {
-            node = node->right;
-        }
-    }
-
-    // insert
-    node = NewNode(key);
-    node->parent = parent;
-    if (parent == nil)
-    {
-        root = node;
-        assert(root->parent == nil);
-    }
-    else
-    {
-        if (key < parent->key)
-        {
-            parent->left = node;
-        }
-        else
-        {
-            parent->right = node;
-        }
-    }
-
-    return node;
-}
-
-void RBTree::InsertFixup(Node* node)
-{
-    while (node->parent->color == Color::Red)
-    {
-        Node* parent = node->parent;
-        Node* grandparent = node->parent->parent;
-        if (parent == grandparent->left)
-        {
-            // parent is left child
-
-            Node* uncle = grandparent->right;
-            if (uncle->color == Color::Red)
-            {
-                // Case 1. Red parent, Red uncle
-                parent->color = Color::Black;
-                uncle->color = Color::Black;
-                grandparent->color = Color::Red;
-                node = grandparent;
-            }
-            else
-            {
-                // Case 2. Red parent, Black uncle, node is right child
-                if (node == parent->right)
-                {
-                    node = node->parent;
-                    RotateLeft(node);
-                    parent = node->parent;
-                    grandparent = node->parent->parent;
-                    // node is left child now
-                }
-
-                // Case 3. Red parent, Black uncle, node is left child
-                parent->color = Color::Black;
-                grandparent->color = Color::Red;
-                RotateRight(grandparent);
-            }
-        }
-        else
-        {
-            // parent is right child
-
-            Node* uncle = grandparent->left;
-            if (uncle->color == Color::Red)
-            {
-                // Case 1. Red parent, Red uncle
-                parent->color = Color::Black;
-                uncle->color = Color::Black;
-                grandparent->color = Color::Red;
-                node = grandparent;
-            }
-            else
-            {
-                // Case 2. Red parent, Black uncle, node is left child
-                if (node == parent->left)
-                {
-                    node = node->parent;
-                    RotateRight(node);
-                    parent = node->parent;
-                    grandparent = node->parent->parent;
-                    // node is right child now
-                }
-
-                // Case 3. Red parent, Black uncle, node is right child
-                parent->color = Color::Black;
-                grandparent->color = Color::Red;
-                RotateLeft(grandparent);
-            }
-        }
-    }
-    // Case 4. Fix root
-    root->color = Color::Black;
-    assert(root->parent == nil);
-}
-
-RBTree::Node* RBTree::FindNode(int key)
-{
-    assert(root->parent == nil);
-
-    Node* node = root;
-    while (node != nil)
-    {
-        if (node->key == key)
-        {
-            return node;
-        }
-        if (key < node->key)
-        {
-            node = node->left;
-        }
-        else
-        {
-            node = node->right;
-        }
-    }
-    return nil;
-}
-
-RBTree::Node* RBTree::FindMin(Node* node)
-{
-    while (node->left != nil)
-    {
-        node = node->left;
-    }
-    return node;
-}
-
-void RBTree::Remove(int key)
-{
-    RemoveNode(key);
-}
-
-void RBTree::RemoveNode(int key)
-{
-    Node* node = FindNode(key);
-    if (node == nil)
-    {
-        return;
-    }
-    // find removing/replacing node y and its child x
-    Node* y = node;
-    Node* x = nil;
-    if (node->left == nil)
-    {
-        x = node->right;
-    }
-    else if (node->right == nil)
-    {
-        x = node->left;
-    }
-    else
-    {
-        y = FindMin(node->right);
-        x = y->right;
-    }
-    // remove/replace
-    x->parent = y->parent;
-    if (x->parent == nil)
-    {
-        root = x;
-        assert(root->parent == nil);
-    }
-    else
-    {
-        if (y == y->parent->left)
-        {
-            y->parent->left = x;
-        }
-        else
-        {
-            y->parent->right = x;
-        }
-    }
-    if (y != node)
-    {
-        node->key = y->key;
-    }
-    // fixup
-    if (y->color == Color::Black)
-    {
-        RemoveFixup(x);
-    }
-
-    DeleteNode(y);
-}
-
-void RBTree::RemoveFixup(Node* node)
-{
-    assert(root->parent == nil);
-
-    while (node != root && node->color == Color::Black)
-    {
-        if (node == node->parent->left)
-        {
-            Node *s = node->parent->right;
-            // Case 1. node's sibling s - Red
-            if (s->color == Color::Red)
-            {
-                s->color = Color::Black;
-                node->parent->color = Color::Red;
-                RotateLeft(node->parent);
-                s = node->parent->right;
-            }
-            // Case 2. node's sibling s - Black, s_left - Black, s_right - Black
-            if (s->left->color == Color::Black && s->right->color == Color::Black)
-            {
-                s->color = Color::Red;
-                node = node->parent;
-            }
-            else
-            {
-                // Case 3. node's sibling s - Black, s_left - Red, s_right - Black
-                if (s->right->color == Color::Black)
-                {
-                    s->left->color = Color::Black;
-                    s->color = Color::Red;
-                    RotateRight(s);
-                    s = node->parent->right;
-                }
-                // Case 4. node's sibling s - Black, s_right - Red
-                s->color = node->parent->color;
-                node->parent->color = Color::Black;
-                s->right->color = Color::Black;
-                RotateLeft(node->parent);
-                node = root;
-                assert(root->parent == nil);
-            }
-        }
-        else
-        {
-            Node *w = node->parent->left;
-            // Case 1. node's sibling s - Red
-            if (w->color == Color::Red)
-            {
-                w->color = Color::Black;
-                node->parent->color = Color::Red;
-                RotateRight(node->parent);
-                w = node->parent->left;
-            }
-            // Case 2. node's sibling s - Black, s_left - Black, s_right - Black
-            if (w->left->color == Color::Black && w->right->color == Color::Black)
-            {
-                w->color = Color::Red;
-                node = node->parent;
-            }
-            else
-            {
-                // Case 3. node's sibling s - Black, s_left - Black, s_right - Red
-                if (w->left->color == Color::Black)
-                {
-                    w->right->color = Color::Black;
-                    w->color = Color::Red;
-                    RotateLeft(w);
-                    w = node->parent->left;
-                }
-                // Case 4. node's sibling s - Black, s_left - Red
-                w->color = node->parent->color;
-                node->parent->color = Color::Black;
-                w->left->color = Color::Black;
-                RotateRight(node->parent);
-                node = root;
-                assert(root->parent == nil);
-            }
-        }
-    }
-    // Case 5. Fix root
-    node->color = Color::Black;
-    assert(root->parent == nil);
-}
-
-bool RBTree::Find(int key)
-{
-    return FindNode(key) != nil;
-}
-
-void RBTree::Clear()
-{
-    DeleteNodesRecursively(root);
-    root = nil;
-}
-
-void RBTree::GetVector(Node* node, std::vector<int>& vec)
-{
-    if (node == nil)
-    {
-        return;
-    }
-    GetVector(node->left, vec);
-    vec.push_back(node->key);
-    GetVector(node->right, vec);
-}
-
-std::vector<int> RBTree::GetVector()
-{
-    std::vector<int> values;
-    GetVector(root, values);
-    return values;
-}
-
-size_t RBTree::Height()
-{
-	return Height(root);
-}
-
-size_t RBTree::Height(Node* node)
-{
-	if (node == nullptr)
-	{
-		return 0;
-	}
-
-	return std::max(Height(node->left), Height(node->right)) + 1;
-}
\ No newline at end of file
+#include "RBTree.h"
+#include "Prefetch.h"
+#include "ParallelSort.h"
+#include <cassert>
+#include <algorithm>
+#include <new>
+#include <thread>
+
+RBTree::RBTree(bool multiset, bool hugePages) :
+    multiset{ multiset },
+    allocator{ hugePages ? new HugePageAllocator(sizeof(Node)) : nullptr }
+{
+}
+
+RBTree::~RBTree()
+{
+    DeleteNodesRecursively(root);
+}
+
+RBTree::Node* RBTree::NewNode(int key)
+{
+    Node* node = allocator != nullptr ? new (allocator->Allocate()) Node : new Node;
+    node->key = key;
+    node->count = 1;
+    node->color = Color::Red;
+    node->left = nil;
+    node->right = nil;
+    node->parent = nil;
+    return node;
+}
+
+void RBTree::DeleteNode(Node* node)
+{
+    if (node == finger)
+    {
+        finger = nil;
+    }
+    if (!InBlock(node))
+    {
+        if (allocator != nullptr)
+        {
+            allocator->Free(node);
+        }
+        else
+        {
+            delete node;
+        }
+        return;
+    }
+    // nodes of the block are not freed one by one
+    blockLive--;
+    if (blockLive == 0)
+    {
+        if (allocator != nullptr)
+        {
+            allocator->FreeBlock(block);
+        }
+        else
+        {
+            ::operator delete(block);
+        }
+        block = nullptr;
+        blockSize = 0;
+    }
+}
+
+void RBTree::DeleteNodesRecursively(Node* node)
+{
+    if (node == nil)
+    {
+        return;
+    }
+    DeleteNodesRecursively(node->left);
+    DeleteNodesRecursively(node->right);
+    DeleteNode(node);
+}
+
+void RBTree::Insert(int key)
+{
+    Insert(key, 1);
+}
+
+void RBTree::Insert(int key, unsigned int count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    InsertNode(root, key, count);
+}
+
+void RBTree::InsertSorted(const std::vector<int>& keys)
+{
+    Node* finger = nil;
+    for (int key : keys)
+    {
+        assert(finger == nil || finger->key <= key);
+        // go up while parent is not greater than key, then key belongs to subtree of start
+        Node* start = root;
+        if (finger != nil)
+        {
+            start = finger;
+            while (start->parent != nil && start->parent->key <= key)
+            {
+                start = start->parent;
+            }
+        }
+        finger = InsertNode(start, key, 1);
+    }
+}
+
+void RBTree::InsertNear(int key)
+{
+    finger = InsertNode(StartNear(finger, key), key, 1);
+}
+
+bool RBTree::FindNear(int key)
+{
+    Node* node = FindNode(StartNear(finger, key), key);
+    if (node == nil)
+    {
+        return false;
+    }
+    finger = node;
+    return true;
+}
+
+RBTree::Node* RBTree::StartNear(Node* finger, int key)
+{
+    if (finger == nil || finger->key == key)
+    {
+        return finger == nil ? root : finger;
+    }
+    // climb while parent is not beyond key; a parent reached from the side of key bounds nothing
+    // new, so the search restarts only at parents reached from the other side
+    Node* start = finger;
+    Node* node = finger;
+    if (key > finger->key)
+    {
+        while (node->parent != nil && node->parent->key <= key)
+        {
+            start = node == node->parent->left ? node->parent : start;
+            node = node->parent;
+        }
+    }
+    else
+    {
+        while (node->parent != nil && node->parent->key >= key)
+        {
+            start = node == node->parent->right ? node->parent : start;
+            node = node->parent;
+        }
+    }
+    return start;
+}
+
+void RBTree::BuildParallel(const int* keys, size_t n, unsigned int threads)
+{
+    threads = BuildThreads(threads);
+    std::vector<int> sorted(keys, keys + n);
+    ParallelSort(sorted, threads);
+    std::vector<unsigned int> counts;
+    if (multiset)
+    {
+        CountRuns(sorted, counts);
+    }
+    else
+    {
+        sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    }
+
+    // splitting at the middle puts every nil at depth floor(log2(n + 1)) or one deeper,
+    // so nodes at that depth are red and all paths have the same black height
+    int redDepth = 0;
+    while ((size_t(2) << redDepth) <= sorted.size() + 1)
+    {
+        redDepth++;
+    }
+
+    Clear();
+    // the node allocator is not thread safe, so with huge pages one thread builds the tree
+    if (allocator != nullptr)
+    {
+        threads = 1;
+    }
+    root = Build(sorted.data(), counts.empty() ? nullptr : counts.data(), sorted.size(), 0, redDepth, threads);
+    if (root != nil)
+    {
+        root->parent = nil;
+    }
+}
+
+// balanced subtree of n sorted keys, left halves go to other threads while there are threads to spare
+RBTree::Node* RBTree::Build(const int* keys, const unsigned int* counts, size_t n, int depth, int redDepth, unsigned int threads)
+{
+    if (n == 0)
+    {
+        return nil;
+    }
+    size_t middle = n / 2;
+    Node* node = NewNode(keys[middle]);
+    node->count = counts != nullptr ? counts[middle] : 1;
+    node->color = depth == redDepth ? Color::Red : Color::Black;
+    const unsigned int* rightCounts = counts != nullptr ? counts + middle + 1 : nullptr;
+    if (threads > 1 && n > 4096)
+    {
+        std::thread worker([&]() { node->left = Build(keys, counts, middle, depth + 1, redDepth, threads / 2); });
+        node->right = Build(keys + middle + 1, rightCounts, n - middle - 1, depth + 1, redDepth, threads - threads / 2);
+        worker.join();
+    }
+    else
+    {
+        node->left = Build(keys, counts, middle, depth + 1, redDepth, 1);
+        node->right = Build(keys + middle + 1, rightCounts, n - middle - 1, depth + 1, redDepth, 1);
+    }
+    // nil is shared by all threads, only real children get parent set
+    if (node->left != nil)
+    {
+        node->left->parent = node;
+    }
+    if (node->right != nil)
+    {
+        node->right->parent = node;
+    }
+    return node;
+}
+
+RBTree::Node* RBTree::InsertNode(Node* start, int key, unsigned int count)
+{
+    Node* parent = nil;
+    Node* node = start;
+
+    // find insertion position
+    while (node != nil)
+    {
+        if (key == node->key)
+        {
+            // existing key, no structural changes
+            if (multiset)
+            {
+                node->count += count;
+            }
+            return node;
+        }
+
+        parent = node;
+        if (key < node->key)
+        {
+            node = node->left;
+        }
+        else
+        {
+            node = node->right;
+        }
+    }
+
+    // insert
+    node = NewNode(key);
+    node->count = multiset ? count : 1;
+    InsertLeaf(node, parent, parent != nil && key < parent->key);
+    return node;
+}
+
+RBTree::Node* RBTree::FindNode(Node* start, int key)
+{
+    assert(root == nil || root->parent == nil);
+
+    Node* node = start;
+    while (node != nil)
+    {
+        if (node->key == key)
+        {
+            return node;
+        }
+        if (key < node->key)
+        {
+            node = node->left;
+        }
+        else
+        {
+            node = node->right;
+        }
+    }
+    return nil;
+}
+
+RBTree::Node* RBTree::FloorNode(Node* node, int key, bool inclusive)
+{
+    Node* best = nil;
+    while (node != nil)
+    {
+        if (node->key < key || (inclusive && node->key == key))
+        {
+            best = node;
+            node = node->right;
+        }
+        else
+        {
+            node = node->left;
+        }
+    }
+    return best;
+}
+
+RBTree::Node* RBTree::CeilingNode(Node* node, int key, bool inclusive)
+{
+    Node* best = nil;
+    while (node != nil)
+    {
+        if (node->key > key || (inclusive && node->key == key))
+        {
+            best = node;
+            node = node->left;
+        }
+        else
+        {
+            node = node->right;
+        }
+    }
+    return best;
+}
+
+void RBTree::Remove(int key)
+{
+    RemoveNode(key, 1);
+}
+
+void RBTree::Remove(int key, unsigned int count)
+{
+    if (count > 0)
+    {
+        RemoveNode(key, count);
+    }
+}
+
+void RBTree::RemoveNode(int key, unsigned int count)
+{
+    Node* node = FindNode(root, key);
+    if (node == nil)
+    {
+        return;
+    }
+    // other occurrences left, no structural changes
+    if (node->count > count)
+    {
+        node->count -= count;
+        return;
+    }
+    DeleteNode(Unlink(node));
+}
+
+bool RBTree::Find(int key)
+{
+    return FindNode(root, key) != nil;
+}
+
+void RBTree::FindBatch(const std::vector<int>& keys, std::vector<bool>& found)
+{
+    FindInterleaved(root, nil, keys, found);
+}
+
+unsigned int RBTree::Count(int key)
+{
+    // nil has zero count
+    return FindNode(root, key)->count;
+}
+
+bool RBTree::Floor(int key, int& result)
+{
+    Node* node = FloorNode(root, key, true);
+    if (node == nil)
+    {
+        return false;
+    }
+    result = node->key;
+    return true;
+}
+
+bool RBTree::Ceiling(int key, int& result)
+{
+    Node* node = CeilingNode(root, key, true);
+    if (node == nil)
+    {
+        return false;
+    }
+    result = node->key;
+    return true;
+}
+
+bool RBTree::Predecessor(int key, int& result)
+{
+    Node* node = FloorNode(root, key, false);
+    if (node == nil)
+    {
+        return false;
+    }
+    result = node->key;
+    return true;
+}
+
+bool RBTree::Successor(int key, int& result)
+{
+    Node* node = CeilingNode(root, key, false);
+    if (node == nil)
+    {
+        return false;
+    }
+    result = node->key;
+    return true;
+}
+
+void RBTree::Floor(const std::vector<int>& probes, std::vector<int>& results, std::vector<bool>& found)
+{
+    results.resize(probes.size());
+    found.resize(probes.size());
+    Node* finger = nil;
+    for (size_t i = 0; i < probes.size(); i++)
+    {
+        assert(i == 0 || probes[i - 1] <= probes[i]);
+        finger = finger == nil ? FloorNode(root, probes[i], true) : FloorNear(finger, probes[i]);
+        found[i] = finger != nil;
+        if (finger != nil)
+        {
+            results[i] = finger->key;
+        }
+    }
+}
+
+void RBTree::Ceiling(const std::vector<int>& probes, std::vector<int>& results, std::vector<bool>& found)
+{
+    results.resize(probes.size());
+    found.resize(probes.size());
+    Node* finger = nil;
+    for (size_t i = 0; i < probes.size(); i++)
+    {
+        assert(i == 0 || probes[i - 1] <= probes[i]);
+        finger = i == 0 ? CeilingNode(root, probes[i], true) : CeilingNear(finger, probes[i]);
+        found[i] = finger != nil;
+        if (finger != nil)
+        {
+            results[i] = finger->key;
+        }
+    }
+}
+
+// finger is floor of a smaller key, so floor of key is finger or lies to the right of it
+RBTree::Node* RBTree::FloorNear(Node* finger, int key)
+{
+    // go up while parent is not greater than key, then floor is in subtree of node
+    Node* node = finger;
+    while (node->parent != nil && node->parent->key <= key)
+    {
+        node = node->parent;
+    }
+    return FloorNode(node, key, true);
+}
+
+// finger is ceiling of a smaller key, nil if that key is greater than all keys
+RBTree::Node* RBTree::CeilingNear(Node* finger, int key)
+{
+    if (finger == nil || finger->key >= key)
+    {
+        return finger;
+    }
+    // go up while parent is less than key, then ceiling is parent or in subtree of node
+    Node* node = finger;
+    while (node->parent != nil && node->parent->key < key)
+    {
+        node = node->parent;
+    }
+    Node* best = CeilingNode(node, key, true);
+    return best != nil ? best : node->parent;
+}
+
+void RBTree::RemoveRange(int lo, int hi)
+{
+    DeleteNodesRecursively(CutRange(lo, hi));
+}
+
+void RBTree::ExtractRange(int lo, int hi, RBTree& out)
+{
+    // finger may move to out
+    finger = nil;
+    out.Clear();
+    Node* middle = CutRange(lo, hi);
+    if (middle == nil)
+    {
+        return;
+    }
+    if (block != nullptr || allocator != nullptr || out.allocator != nullptr)
+    {
+        middle = Relocate(middle, out);
+    }
+    MoveNodes(middle, out);
+    middle->color = Color::Black;
+    middle->parent = out.nil;
+    out.root = middle;
+}
+
+void RBTree::Compact()
+{
+    if (root == nil)
+    {
+        return;
+    }
+    finger = nil;
+    std::vector<Node*> order;
+    order.reserve(Size(root));
+    // Height counts nil below leaves as a level
+    VebOrder(root, Height(root) - 1, order);
+
+    // copy nodes in order, every old node keeps address of its copy in parent
+    Node* newBlock = static_cast<Node*>(allocator != nullptr ? allocator->AllocateBlock(order.size()) : ::operator new(order.size() * sizeof(Node)));
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        new (newBlock + i) Node(*order[i]);
+        order[i]->parent = newBlock + i;
+    }
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        Node* node = newBlock + i;
+        if (node->left != nil)
+        {
+            node->left = node->left->parent;
+        }
+        if (node->right != nil)
+        {
+            node->right = node->right->parent;
+        }
+        if (node->parent != nil)
+        {
+            node->parent = node->parent->parent;
+        }
+    }
+    root = root->parent;
+
+    // frees previous block with its last node
+    for (Node* node : order)
+    {
+        DeleteNode(node);
+    }
+    block = newBlock;
+    blockSize = order.size();
+    blockLive = order.size();
+}
+
+int RBTree::BlackHeight(Node* node)
+{
+    int blackHeight = 0;
+    while (node != nil)
+    {
+        if (node->color == Color::Black)
+        {
+            blackHeight++;
+        }
+        node = node->left;
+    }
+    return blackHeight;
+}
+
+// Join and Split work on detached subtrees (parent == nil) with known black heights.
+// Rotations and InsertFixup at the top of a subtree update root, so Join uses root
+// as the top of the subtree being fixed.
+RBTree::Node* RBTree::Join(Node* left, int leftBlackHeight, Node* middle, Node* right, int rightBlackHeight, int& blackHeight)
+{
+    // make both roots black
+    if (left->color == Color::Red)
+    {
+        left->color = Color::Black;
+        leftBlackHeight++;
+    }
+    if (right->color == Color::Red)
+    {
+        right->color = Color::Black;
+        rightBlackHeight++;
+    }
+    middle->parent = nil;
+
+    if (leftBlackHeight == rightBlackHeight)
+    {
+        middle->left = left;
+        middle->right = right;
+        middle->color = Color::Black;
+        if (left != nil)
+        {
+            left->parent = middle;
+        }
+        if (right != nil)
+        {
+            right->parent = middle;
+        }
+        blackHeight = leftBlackHeight + 1;
+        return middle;
+    }
+
+    if (leftBlackHeight > rightBlackHeight)
+    {
+        // go down the right spine of left to a black node of right's black height
+        root = left;
+        Node* parent = nil;
+        Node* node = left;
+        int nodeBlackHeight = leftBlackHeight;
+        while (node->color == Color::Red || nodeBlackHeight != rightBlackHeight)
+        {
+            if (node->color == Color::Black)
+            {
+                nodeBlackHeight--;
+            }
+            parent = node;
+            node = node->right;
+        }
+        // insert red middle in place of node and fix red-red violation
+        middle->left = node;
+        middle->right = right;
+        middle->color = Color::Red;
+        if (node != nil)
+        {
+            node->parent = middle;
+        }
+        if (right != nil)
+        {
+            right->parent = middle;
+        }
+        parent->right = middle;
+        middle->parent = parent;
+        blackHeight = InsertFixup(middle) ? leftBlackHeight + 1 : leftBlackHeight;
+        return root;
+    }
+
+    // go down the left spine of right to a black node of left's black height
+    root = right;
+    Node* parent = nil;
+    Node* node = right;
+    int nodeBlackHeight = rightBlackHeight;
+    while (node->color == Color::Red || nodeBlackHeight != leftBlackHeight)
+    {
+        if (node->color == Color::Black)
+        {
+            nodeBlackHeight--;
+        }
+        parent = node;
+        node = node->left;
+    }
+    middle->right = node;
+    middle->left = left;
+    middle->color = Color::Red;
+    if (node != nil)
+    {
+        node->parent = middle;
+    }
+    if (left != nil)
+    {
+        left->parent = middle;
+    }
+    parent->left = middle;
+    middle->parent = parent;
+    blackHeight = InsertFixup(middle) ? rightBlackHeight + 1 : rightBlackHeight;
+    return root;
+}
+
+RBTree::Node* RBTree::Join(Node* left, int leftBlackHeight, Node* right, int rightBlackHeight)
+{
+    if (left == nil)
+    {
+        return right;
+    }
+    if (right == nil)
+    {
+        return left;
+    }
+    Node* less;
+    Node* min;
+    Node* greater;
+    int lessBlackHeight;
+    int greaterBlackHeight;
+    int blackHeight;
+    Split(right, rightBlackHeight, FindMin(right)->key, less, lessBlackHeight, min, greater, greaterBlackHeight);
+    return Join(left, leftBlackHeight, min, greater, greaterBlackHeight, blackHeight);
+}
+
+// split node's subtree into keys less than key, node with key (or nil) and greater keys
+void RBTree::Split(Node* node, int blackHeight, int key, Node*& less, int& lessBlackHeight, Node*& equal, Node*& greater, int& greaterBlackHeight)
+{
+    if (node == nil)
+    {
+        less = nil;
+        equal = nil;
+        greater = nil;
+        lessBlackHeight = 0;
+        greaterBlackHeight = 0;
+        return;
+    }
+
+    // detach node from its children
+    Node* left = node->left;
+    Node* right = node->right;
+    int childBlackHeight = node->color == Color::Black ? blackHeight - 1 : blackHeight;
+    if (left != nil)
+    {
+        left->parent = nil;
+    }
+    if (right != nil)
+    {
+        right->parent = nil;
+    }
+    node->left = nil;
+    node->right = nil;
+    node->parent = nil;
+    node->color = Color::Red;
+
+    if (key == node->key)
+    {
+        less = left;
+        lessBlackHeight = childBlackHeight;
+        equal = node;
+        greater = right;
+        greaterBlackHeight = childBlackHeight;
+    }
+    else if (key < node->key)
+    {
+        Node* lessGreater;
+        int lessGreaterBlackHeight;
+        Split(left, childBlackHeight, key, less, lessBlackHeight, equal, lessGreater, lessGreaterBlackHeight);
+        greater = Join(lessGreater, lessGreaterBlackHeight, node, right, childBlackHeight, greaterBlackHeight);
+    }
+    else
+    {
+        Node* greaterLess;
+        int greaterLessBlackHeight;
+        Split(right, childBlackHeight, key, greaterLess, greaterLessBlackHeight, equal, greater, greaterBlackHeight);
+        less = Join(left, childBlackHeight, node, greaterLess, greaterLessBlackHeight, lessBlackHeight);
+    }
+}
+
+// detach subtree with keys in [lo, hi], the rest is joined back with one pass per split level
+RBTree::Node* RBTree::CutRange(int lo, int hi)
+{
+    if (root == nil || lo > hi)
+    {
+        return nil;
+    }
+
+    Node* less;
+    Node* loNode;
+    Node* rest;
+    Node* middle;
+    Node* hiNode;
+    Node* greater;
+    int lessBlackHeight;
+    int restBlackHeight;
+    int middleBlackHeight;
+    int greaterBlackHeight;
+    Split(root, BlackHeight(root), lo, less, lessBlackHeight, loNode, rest, restBlackHeight);
+    Split(rest, restBlackHeight, hi, middle, middleBlackHeight, hiNode, greater, greaterBlackHeight);
+    if (loNode != nil)
+    {
+        middle = Join(nil, 0, loNode, middle, middleBlackHeight, middleBlackHeight);
+    }
+    if (hiNode != nil)
+    {
+        middle = Join(middle, middleBlackHeight, hiNode, nil, 0, middleBlackHeight);
+    }
+    root = Join(less, lessBlackHeight, greater, greaterBlackHeight);
+    root->color = Color::Black;
+    root->parent = nil;
+    return middle;
+}
+
+// relink nil leaves of node's subtree to the other tree's sentinel
+void RBTree::MoveNodes(Node* node, RBTree& to)
+{
+    if (node->left == nil)
+    {
+        node->left = to.nil;
+    }
+    else
+    {
+        MoveNodes(node->left, to);
+    }
+    if (node->right == nil)
+    {
+        node->right = to.nil;
+    }
+    else
+    {
+        MoveNodes(node->right, to);
+    }
+}
+
+bool RBTree::InBlock(Node* node)
+{
+    return block != nullptr && node >= block && node < block + blockSize;
+}
+
+// copy nodes of subtree that to can't free as they are into memory of to, so the subtree can go there
+RBTree::Node* RBTree::Relocate(Node* node, RBTree& to)
+{
+    if (node == nil)
+    {
+        return nil;
+    }
+    node->left = Relocate(node->left, to);
+    node->right = Relocate(node->right, to);
+    if (InBlock(node) || allocator != nullptr || to.allocator != nullptr)
+    {
+        Node* copy = to.NewNode(node->key);
+        *copy = *node;
+        DeleteNode(node);
+        node = copy;
+    }
+    if (node->left != nil)
+    {
+        node->left->parent = node;
+    }
+    if (node->right != nil)
+    {
+        node->right->parent = node;
+    }
+    return node;
+}
+
+// van Emde Boas order of the top height levels of subtree: the upper half of the levels,
+// then every subtree hanging below them, each laid out the same way
+void RBTree::VebOrder(Node* node, size_t height, std::vector<Node*>& order)
+{
+    if (node == nil || height == 0)
+    {
+        return;
+    }
+    if (height == 1)
+    {
+        order.push_back(node);
+        return;
+    }
+    size_t topHeight = height / 2;
+    VebOrder(node, topHeight, order);
+    std::vector<Node*> bottoms;
+    CollectAtDepth(node, topHeight, bottoms);
+    for (Node* bottom : bottoms)
+    {
+        VebOrder(bottom, height - topHeight, order);
+    }
+}
+
+void RBTree::CollectAtDepth(Node* node, size_t depth, std::vector<Node*>& nodes)
+{
+    if (node == nil)
+    {
+        return;
+    }
+    if (depth == 0)
+    {
+        nodes.push_back(node);
+        return;
+    }
+    CollectAtDepth(node->left, depth - 1, nodes);
+    CollectAtDepth(node->right, depth - 1, nodes);
+}
+
+void RBTree::Clear()
+{
+    DeleteNodesRecursively(root);
+    root = nil;
+}
+
+void RBTree::GetVector(Node* node, std::vector<int>& vec)
+{
+    if (node == nil)
+    {
+        return;
+    }
+    GetVector(node->left, vec);
+    vec.push_back(node->key);
+    GetVector(node->right, vec);
+}
+
+std::vector<int> RBTree::GetVector()
+{
+    std::vector<int> values;
+    GetVector(root, values);
+    return values;
+}
+
+size_t RBTree::Height()
+{
+	return Height(root);
+}
+
+size_t RBTree::Height(Node* node)
+{
+	if (node == nullptr)
+	{
+		return 0;
+	}
+
+	return std::max(Height(node->left), Height(node->right)) + 1;
+}
+
+size_t RBTree::MemoryUsage()
+{
+    return Size(root) * sizeof(Node);
+}
+
+size_t RBTree::HugePageBytes()
+{
+    return allocator != nullptr ? allocator->HugePageBytes() : 0;
+}
+
+size_t RBTree::RebalanceSteps()
+{
+    return rebalanceSteps;
+}
+
+size_t RBTree::Size(Node* node)
+{
+    if (node == nil)
+    {
+        return 0;
+    }
+    return Size(node->left) + Size(node->right) + 1;
+}
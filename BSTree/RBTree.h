@@ -1,54 +1,110 @@
-#pragma once
-
-#include <vector>
-
-class RBTree
-{
-public:
-    RBTree();
-    ~RBTree();
-
-    void Insert(int key);
-    void Remove(int key);
-    bool Find(int key);
-    void Clear();
-    std::vector<int> GetVector();
-	size_t Height();
-
-private:
-
-    enum class Color { Black, Red };
-
-    struct Node
-    {
-        Node *left;
-        Node *right;
-        Node *parent;
-        Color color;
-        int key;
-
-        Node();
-        Node(int key);
-    };
-
-    Node* NewNode(int key);
-    void DeleteNode(Node* node);
-    void DeleteNodesRecursively(Node* node);
-
-    void RotateLeft(Node* p);
-    void RotateRight(Node* p);
-    Node* InsertNode(int key);
-    void InsertFixup(Node* node);
-    Node* FindNode(int key);
-    Node* FindMin(Node* node);
-    void RemoveNode(int key);
-    void RemoveFixup(Node* node);
-
-    void GetVector(Node* node, std::vector<int>& vec);
-	size_t Height(Node* node);
-
-    Node sentinel;
-    Node* const nil = &sentinel;
-    Node *root = nil;
-};
-
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "HugePageAllocator.h"
+#include "RBTreeBase.h"
+
+// key of an RBTree node and its number of occurrences
+struct RBTreeEntry
+{
+    int key;
+    unsigned int count;
+};
+
+class RBTree : private RBTreeBase<RBTreeEntry>
+{
+public:
+    // in multiset mode every key keeps count of its occurrences,
+    // with hugePages nodes are allocated from 2 MB regions backed by huge pages where possible
+    RBTree(bool multiset = false, bool hugePages = false);
+    ~RBTree();
+
+    void Insert(int key);
+    // add count occurrences of key, in set mode key is stored once
+    void Insert(int key, unsigned int count);
+    void Remove(int key);
+    // remove up to count occurrences of key
+    void Remove(int key, unsigned int count);
+    // insert sorted keys, search for every key starts near the previous one
+    void InsertSorted(const std::vector<int>& keys);
+    // replace content with keys: they are sorted, deduplicated and built into a balanced tree,
+    // subtrees are built by threads in parallel; threads 0 means one per hardware thread
+    void BuildParallel(const int* keys, size_t n, unsigned int threads = 0);
+    bool Find(int key);
+    // Insert and Find starting at the node of the previous InsertNear/FindNear: the search goes up
+    // from it until key is in the subtree, then down, so keys d apart cost O(log d) instead of O(log n)
+    void InsertNear(int key);
+    bool FindNear(int key);
+    // Find of every key, descents of a group of keys are interleaved so their cache misses overlap
+    void FindBatch(const std::vector<int>& keys, std::vector<bool>& found);
+    unsigned int Count(int key);
+    // largest key <= key, smallest key >= key, largest key < key, smallest key > key;
+    // return false if there is no such key
+    bool Floor(int key, int& result);
+    bool Ceiling(int key, int& result);
+    bool Predecessor(int key, int& result);
+    bool Successor(int key, int& result);
+    // Floor/Ceiling of every probe, probes are sorted; found[i] tells if results[i] is set
+    void Floor(const std::vector<int>& probes, std::vector<int>& results, std::vector<bool>& found);
+    void Ceiling(const std::vector<int>& probes, std::vector<int>& results, std::vector<bool>& found);
+    // remove all keys in [lo, hi]
+    void RemoveRange(int lo, int hi);
+    // move all keys in [lo, hi] to out, replacing its content
+    void ExtractRange(int lo, int hi, RBTree& out);
+    // relocate all nodes into one new block in van Emde Boas order, so a lookup touches fewer
+    // cache lines and pages; nodes inserted later come from the heap until the next Compact
+    void Compact();
+    void Clear();
+    std::vector<int> GetVector();
+	size_t Height();
+    size_t MemoryUsage();
+    // bytes of node memory backed by huge pages, 0 without hugePages
+    size_t HugePageBytes();
+    // loop steps of insert and remove fixups so far, telling how far rebalancing went up
+    size_t RebalanceSteps();
+
+private:
+
+    Node* NewNode(int key);
+    void DeleteNode(Node* node);
+    void DeleteNodesRecursively(Node* node);
+
+    // returns the node holding key
+    Node* InsertNode(Node* start, int key, unsigned int count);
+    Node* Build(const int* keys, const unsigned int* counts, size_t n, int depth, int redDepth, unsigned int threads);
+    Node* FindNode(Node* start, int key);
+    // lowest ancestor of finger whose subtree would hold key
+    Node* StartNear(Node* finger, int key);
+    void RemoveNode(int key, unsigned int count);
+    Node* FloorNode(Node* node, int key, bool inclusive);
+    Node* CeilingNode(Node* node, int key, bool inclusive);
+    Node* FloorNear(Node* finger, int key);
+    Node* CeilingNear(Node* finger, int key);
+    int BlackHeight(Node* node);
+    Node* Join(Node* left, int leftBlackHeight, Node* middle, Node* right, int rightBlackHeight, int& blackHeight);
+    Node* Join(Node* left, int leftBlackHeight, Node* right, int rightBlackHeight);
+    void Split(Node* node, int blackHeight, int key, Node*& less, int& lessBlackHeight, Node*& equal, Node*& greater, int& greaterBlackHeight);
+    Node* CutRange(int lo, int hi);
+    void MoveNodes(Node* node, RBTree& to);
+    bool InBlock(Node* node);
+    Node* Relocate(Node* node, RBTree& to);
+    void VebOrder(Node* node, size_t height, std::vector<Node*>& order);
+    void CollectAtDepth(Node* node, size_t depth, std::vector<Node*>& nodes);
+
+    void GetVector(Node* node, std::vector<int>& vec);
+	size_t Height(Node* node);
+    size_t Size(Node* node);
+
+    // node of the last InsertNear/FindNear, nil once it is deleted or moved
+    Node* finger = nil;
+    bool multiset;
+    // nodes placed by Compact, the block is freed when the last of them is deleted
+    Node* block = nullptr;
+    size_t blockSize = 0;
+    size_t blockLive = 0;
+    // allocator of nodes with hugePages, otherwise new and delete
+    std::unique_ptr<HugePageAllocator> allocator;
+};
+
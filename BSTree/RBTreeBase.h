@@ -0,0 +1,403 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include "Augmentation.h"
+
+// Red-black balancing shared by RBTree, IntervalTree and AugmentedRBTree: rotations,
+// insert and remove fixups. A node is Payload (key and whatever goes with it) plus
+// links and color; the sentinel nil stands for every empty child and is a
+// value-initialized Payload. Augmentation::Update(node) runs on every node whose
+// subtree changed, children before parents, so a node can keep a summary of its subtree.
+template <typename Payload, typename Augmentation = NoAugmentation>
+class RBTreeBase
+{
+protected:
+    enum class Color { Black, Red };
+
+    struct Node : Payload
+    {
+        Node *left;
+        Node *right;
+        Node *parent;
+        Color color;
+    };
+
+    RBTreeBase();
+
+    void RotateLeft(Node* p);
+    void RotateRight(Node* p);
+    // link node as a red leaf under parent (root if parent is nil) and rebalance
+    void InsertLeaf(Node* node, Node* parent, bool left);
+    // returns true if black height of the tree increased
+    bool InsertFixup(Node* node);
+    // take node's entry out of the tree, returns the node to free: node itself,
+    // or its successor whose payload was moved into node
+    Node* Unlink(Node* node);
+    void RemoveFixup(Node* node);
+    // Update of node and all its ancestors, after payload of node changed
+    void UpdateUp(Node* node);
+    Node* FindMin(Node* node);
+
+    Node sentinel;
+    Node* const nil = &sentinel;
+    Node *root = nil;
+    // loop steps of insert and remove fixups so far
+    size_t rebalanceSteps = 0;
+};
+
+template <typename Payload, typename Augmentation>
+RBTreeBase<Payload, Augmentation>::RBTreeBase() :
+    sentinel{}
+{
+    nil->color = Color::Black;
+}
+
+template <typename Payload, typename Augmentation>
+void RBTreeBase<Payload, Augmentation>::RotateLeft(Node* p)
+{
+    assert(p != nil);
+    assert(p->right != nil);
+    assert(root->parent == nil);
+
+    Node* q = p->right;
+
+    // p - c link
+    p->right = q->left;
+    if (p->right != nil)
+    {
+        p->right->parent = p;
+    }
+    // q - parent link
+    q->parent = p->parent;
+    if (q->parent == nil)
+    {
+        root = q;
+        assert(root->parent == nil);
+    }
+    else
+    {
+        if (p == p->parent->left)
+        {
+            q->parent->left = q;
+        }
+        else
+        {
+            q->parent->right = q;
+        }
+    }
+    // p - q link
+    q->left = p;
+    p->parent = q;
+    // p is below q now
+    Augmentation::Update(p);
+    Augmentation::Update(q);
+}
+
+template <typename Payload, typename Augmentation>
+void RBTreeBase<Payload, Augmentation>::RotateRight(Node* p)
+{
+    assert(p != nil);
+    assert(p->left != nil);
+    assert(root->parent == nil);
+
+    Node* q = p->left;
+
+    // p - c link
+    p->left = q->right;
+    if (p->left != nil)
+    {
+        p->left->parent = p;
+    }
+    // q - parent link
+    q->parent = p->parent;
+    if (q->parent == nil)
+    {
+        root = q;
+        assert(root->parent == nil);
+    }
+    else
+    {
+        if (p == p->parent->left)
+        {
+            q->parent->left = q;
+        }
+        else
+        {
+            q->parent->right = q;
+        }
+    }
+    // p - q link
+    q->right = p;
+    p->parent = q;
+    // p is below q now
+    Augmentation::Update(p);
+    Augmentation::Update(q);
+}
+
+template <typename Payload, typename Augmentation>
+void RBTreeBase<Payload, Augmentation>::InsertLeaf(Node* node, Node* parent, bool left)
+{
+    node->left = nil;
+    node->right = nil;
+    node->parent = parent;
+    node->color = Color::Red;
+    if (parent == nil)
+    {
+        root = node;
+        assert(root->parent == nil);
+    }
+    else
+    {
+        if (left)
+        {
+            parent->left = node;
+        }
+        else
+        {
+            parent->right = node;
+        }
+    }
+    // new node changes subtrees of all its ancestors, rotations keep that up to date
+    UpdateUp(node);
+    // rotations move node but keep it in the tree
+    InsertFixup(node);
+}
+
+template <typename Payload, typename Augmentation>
+bool RBTreeBase<Payload, Augmentation>::InsertFixup(Node* node)
+{
+    while (node->parent->color == Color::Red)
+    {
+        rebalanceSteps++;
+        Node* parent = node->parent;
+        Node* grandparent = node->parent->parent;
+        if (parent == grandparent->left)
+        {
+            // parent is left child
+
+            Node* uncle = grandparent->right;
+            if (uncle->color == Color::Red)
+            {
+                // Case 1. Red parent, Red uncle
+                parent->color = Color::Black;
+                uncle->color = Color::Black;
+                grandparent->color = Color::Red;
+                node = grandparent;
+            }
+            else
+            {
+                // Case 2. Red parent, Black uncle, node is right child
+                if (node == parent->right)
+                {
+                    node = node->parent;
+                    RotateLeft(node);
+                    parent = node->parent;
+                    grandparent = node->parent->parent;
+                    // node is left child now
+                }
+
+                // Case 3. Red parent, Black uncle, node is left child
+                parent->color = Color::Black;
+                grandparent->color = Color::Red;
+                RotateRight(grandparent);
+            }
+        }
+        else
+        {
+            // parent is right child
+
+            Node* uncle = grandparent->left;
+            if (uncle->color == Color::Red)
+            {
+                // Case 1. Red parent, Red uncle
+                parent->color = Color::Black;
+                uncle->color = Color::Black;
+                grandparent->color = Color::Red;
+                node = grandparent;
+            }
+            else
+            {
+                // Case 2. Red parent, Black uncle, node is left child
+                if (node == parent->left)
+                {
+                    node = node->parent;
+                    RotateRight(node);
+                    parent = node->parent;
+                    grandparent = node->parent->parent;
+                    // node is right child now
+                }
+
+                // Case 3. Red parent, Black uncle, node is right child
+                parent->color = Color::Black;
+                grandparent->color = Color::Red;
+                RotateLeft(grandparent);
+            }
+        }
+    }
+    // Case 4. Fix root
+    bool blackHeightIncreased = root->color == Color::Red;
+    root->color = Color::Black;
+    assert(root->parent == nil);
+    return blackHeightIncreased;
+}
+
+template <typename Payload, typename Augmentation>
+typename RBTreeBase<Payload, Augmentation>::Node* RBTreeBase<Payload, Augmentation>::Unlink(Node* node)
+{
+    // find removing/replacing node y and its child x
+    Node* y = node;
+    Node* x = nil;
+    if (node->left == nil)
+    {
+        x = node->right;
+    }
+    else if (node->right == nil)
+    {
+        x = node->left;
+    }
+    else
+    {
+        y = FindMin(node->right);
+        x = y->right;
+    }
+    // remove/replace
+    x->parent = y->parent;
+    if (x->parent == nil)
+    {
+        root = x;
+        assert(root->parent == nil);
+    }
+    else
+    {
+        if (y == y->parent->left)
+        {
+            y->parent->left = x;
+        }
+        else
+        {
+            y->parent->right = x;
+        }
+    }
+    if (y != node)
+    {
+        static_cast<Payload&>(*node) = static_cast<const Payload&>(*y);
+    }
+    // node is an ancestor of x, so this updates node too
+    UpdateUp(x->parent);
+    // fixup
+    if (y->color == Color::Black)
+    {
+        RemoveFixup(x);
+    }
+    return y;
+}
+
+template <typename Payload, typename Augmentation>
+void RBTreeBase<Payload, Augmentation>::RemoveFixup(Node* node)
+{
+    assert(root->parent == nil);
+
+    while (node != root && node->color == Color::Black)
+    {
+        rebalanceSteps++;
+        if (node == node->parent->left)
+        {
+            Node *s = node->parent->right;
+            // Case 1. node's sibling s - Red
+            if (s->color == Color::Red)
+            {
+                s->color = Color::Black;
+                node->parent->color = Color::Red;
+                RotateLeft(node->parent);
+                s = node->parent->right;
+            }
+            // Case 2. node's sibling s - Black, s_left - Black, s_right - Black
+            if (s->left->color == Color::Black && s->right->color == Color::Black)
+            {
+                s->color = Color::Red;
+                node = node->parent;
+            }
+            else
+            {
+                // Case 3. node's sibling s - Black, s_left - Red, s_right - Black
+                if (s->right->color == Color::Black)
+                {
+                    s->left->color = Color::Black;
+                    s->color = Color::Red;
+                    RotateRight(s);
+                    s = node->parent->right;
+                }
+                // Case 4. node's sibling s - Black, s_right - Red
+                s->color = node->parent->color;
+                node->parent->color = Color::Black;
+                s->right->color = Color::Black;
+                RotateLeft(node->parent);
+                node = root;
+                assert(root->parent == nil);
+            }
+        }
+        else
+        {
+            Node *w = node->parent->left;
+            // Case 1. node's sibling s - Red
+            if (w->color == Color::Red)
+            {
+                w->color = Color::Black;
+                node->parent->color = Color::Red;
+                RotateRight(node->parent);
+                w = node->parent->left;
+            }
+            // Case 2. node's sibling s - Black, s_left - Black, s_right - Black
+            if (w->left->color == Color::Black && w->right->color == Color::Black)
+            {
+                w->color = Color::Red;
+                node = node->parent;
+            }
+            else
+            {
+                // Case 3. node's sibling s - Black, s_left - Black, s_right - Red
+                if (w->left->color == Color::Black)
+                {
+                    w->right->color = Color::Black;
+                    w->color = Color::Red;
+                    RotateLeft(w);
+                    w = node->parent->left;
+                }
+                // Case 4. node's sibling s - Black, s_left - Red
+                w->color = node->parent->color;
+                node->parent->color = Color::Black;
+                w->left->color = Color::Black;
+                RotateRight(node->parent);
+                node = root;
+                assert(root->parent == nil);
+            }
+        }
+    }
+    // Case 5. Fix root
+    node->color = Color::Black;
+    assert(root->parent == nil);
+}
+
+template <typename Payload, typename Augmentation>
+void RBTreeBase<Payload, Augmentation>::UpdateUp(Node* node)
+{
+    if constexpr (Augmentation::enabled)
+    {
+        while (node != nil)
+        {
+            Augmentation::Update(node);
+            node = node->parent;
+        }
+    }
+}
+
+template <typename Payload, typename Augmentation>
+typename RBTreeBase<Payload, Augmentation>::Node* RBTreeBase<Payload, Augmentation>::FindMin(Node* node)
+{
+    while (node->left != nil)
+    {
+        node = node->left;
+    }
+    return node;
+}
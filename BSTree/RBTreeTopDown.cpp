@@ -0,0 +1,330 @@
+#include "RBTreeTopDown.h"
+#include <cassert>
+#include <algorithm>
+
+RBTreeTopDown::Node::Node() :
+    left{ nullptr },
+    right{ nullptr },
+    key{ 0 },
+    color{ Color::Black }
+{
+}
+
+RBTreeTopDown::Node::Node(int key) :
+    left{ nullptr },
+    right{ nullptr },
+    key{ key },
+    color{ Color::Red }
+{
+}
+
+RBTreeTopDown::RBTreeTopDown()
+{
+}
+
+RBTreeTopDown::~RBTreeTopDown()
+{
+    DeleteNodesRecursively(root);
+}
+
+RBTreeTopDown::Node* RBTreeTopDown::NewNode(int key)
+{
+    return new Node(key);
+}
+
+void RBTreeTopDown::DeleteNode(Node* node)
+{
+    delete node;
+}
+
+void RBTreeTopDown::DeleteNodesRecursively(Node* node)
+{
+    if (node == nullptr)
+    {
+        return;
+    }
+    DeleteNodesRecursively(node->left);
+    DeleteNodesRecursively(node->right);
+    DeleteNode(node);
+}
+
+bool RBTreeTopDown::IsRed(Node* node)
+{
+    return node != nullptr && node->color == Color::Red;
+}
+
+RBTreeTopDown::Node*& RBTreeTopDown::Child(Node* node, bool right)
+{
+    return right ? node->right : node->left;
+}
+
+// rotate p towards 'right' direction, returns new subtree root
+RBTreeTopDown::Node* RBTreeTopDown::RotateSingle(Node* p, bool right)
+{
+    Node* q = Child(p, !right);
+
+    Child(p, !right) = Child(q, right);
+    Child(q, right) = p;
+
+    p->color = Color::Red;
+    q->color = Color::Black;
+    return q;
+}
+
+RBTreeTopDown::Node* RBTreeTopDown::RotateDouble(Node* p, bool right)
+{
+    Child(p, !right) = RotateSingle(Child(p, !right), !right);
+    return RotateSingle(p, right);
+}
+
+void RBTreeTopDown::Insert(int key)
+{
+    InsertNode(key);
+}
+
+void RBTreeTopDown::InsertNode(int key)
+{
+    if (root == nullptr)
+    {
+        root = NewNode(key);
+        root->color = Color::Black;
+        return;
+    }
+
+    // false root keeps the great-grandparent always valid
+    Node head;
+    Node* t = &head;
+    Node* g = nullptr;
+    Node* p = nullptr;
+    Node* q = root;
+    head.right = root;
+    bool dir = false;
+    bool last = false;
+
+    // go down, splitting 4-nodes and fixing red-red violations
+    while (true)
+    {
+        if (q == nullptr)
+        {
+            // insert new node at the bottom
+            q = NewNode(key);
+            Child(p, dir) = q;
+        }
+        else if (IsRed(q->left) && IsRed(q->right))
+        {
+            // Color flip
+            q->color = Color::Red;
+            q->left->color = Color::Black;
+            q->right->color = Color::Black;
+        }
+
+        if (IsRed(q) && IsRed(p))
+        {
+            // Fix red-red violation with the grandparent rotation
+            bool dir2 = t->right == g;
+            if (q == Child(p, last))
+            {
+                Child(t, dir2) = RotateSingle(g, !last);
+            }
+            else
+            {
+                Child(t, dir2) = RotateDouble(g, !last);
+            }
+        }
+
+        if (q->key == key)
+        {
+            break;
+        }
+
+        last = dir;
+        dir = q->key < key;
+        if (g != nullptr)
+        {
+            t = g;
+        }
+        g = p;
+        p = q;
+        q = Child(q, dir);
+    }
+
+    root = head.right;
+    root->color = Color::Black;
+}
+
+void RBTreeTopDown::Remove(int key)
+{
+    RemoveNode(key);
+}
+
+void RBTreeTopDown::RemoveNode(int key)
+{
+    if (root == nullptr)
+    {
+        return;
+    }
+
+    Node head;
+    Node* q = &head;
+    Node* p = nullptr;
+    Node* g = nullptr;
+    Node* found = nullptr;
+    head.right = root;
+    bool dir = true;
+
+    // go down to the in-order predecessor (or the node itself),
+    // pushing a red node along so that the removed node is red
+    while (Child(q, dir) != nullptr)
+    {
+        bool last = dir;
+
+        g = p;
+        p = q;
+        q = Child(q, dir);
+        dir = q->key < key;
+
+        if (q->key == key)
+        {
+            found = q;
+        }
+
+        if (IsRed(q) || IsRed(Child(q, dir)))
+        {
+            continue;
+        }
+
+        if (IsRed(Child(q, !dir)))
+        {
+            // Case 1. Red sibling of the next node, rotate it up
+            Child(p, last) = RotateSingle(q, dir);
+            p = Child(p, last);
+        }
+        else
+        {
+            Node* s = Child(p, !last);
+            if (s == nullptr)
+            {
+                continue;
+            }
+            if (!IsRed(s->left) && !IsRed(s->right))
+            {
+                // Case 2. Black sibling with black children, color flip
+                p->color = Color::Black;
+                s->color = Color::Red;
+                q->color = Color::Red;
+            }
+            else
+            {
+                // Case 3. Black sibling with a red child, rotate
+                bool dir2 = g->right == p;
+                if (IsRed(Child(s, last)))
+                {
+                    Child(g, dir2) = RotateDouble(p, last);
+                }
+                else
+                {
+                    Child(g, dir2) = RotateSingle(p, last);
+                }
+                // fix colors
+                Node* top = Child(g, dir2);
+                q->color = Color::Red;
+                top->color = Color::Red;
+                top->left->color = Color::Black;
+                top->right->color = Color::Black;
+            }
+        }
+    }
+
+    // replace and remove
+    if (found != nullptr)
+    {
+        found->key = q->key;
+        Child(p, p->right == q) = Child(q, q->left == nullptr);
+        DeleteNode(q);
+    }
+
+    root = head.right;
+    if (root != nullptr)
+    {
+        root->color = Color::Black;
+    }
+}
+
+RBTreeTopDown::Node* RBTreeTopDown::FindNode(int key)
+{
+    Node* node = root;
+    while (node != nullptr)
+    {
+        if (node->key == key)
+        {
+            return node;
+        }
+        if (key < node->key)
+        {
+            node = node->left;
+        }
+        else
+        {
+            node = node->right;
+        }
+    }
+    return nullptr;
+}
+
+bool RBTreeTopDown::Find(int key)
+{
+    return FindNode(key) != nullptr;
+}
+
+void RBTreeTopDown::Clear()
+{
+    DeleteNodesRecursively(root);
+    root = nullptr;
+}
+
+void RBTreeTopDown::GetVector(Node* node, std::vector<int>& vec)
+{
+    if (node == nullptr)
+    {
+        return;
+    }
+    GetVector(node->left, vec);
+    vec.push_back(node->key);
+    GetVector(node->right, vec);
+}
+
+std::vector<int> RBTreeTopDown::GetVector()
+{
+    std::vector<int> values;
+    GetVector(root, values);
+    return values;
+}
+
+size_t RBTreeTopDown::Height()
+{
+    return Height(root);
+}
+
+size_t RBTreeTopDown::Height(Node* node)
+{
+    if (node == nullptr)
+    {
+        return 0;
+    }
+
+    return std::max(Height(node->left), Height(node->right)) + 1;
+}
+
+size_t RBTreeTopDown::MemoryUsage()
+{
+    return Size(root) * sizeof(Node);
+}
+
+size_t RBTreeTopDown::Size(Node* node)
+{
+    if (node == nullptr)
+    {
+        return 0;
+    }
+    return Size(node->left) + Size(node->right) + 1;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Red-black tree with single pass top-down insert/remove.
+// Colors are fixed on the way down, so nodes don't need parent links.
+class RBTreeTopDown
+{
+public:
+    RBTreeTopDown();
+    ~RBTreeTopDown();
+
+    void Insert(int key);
+    void Remove(int key);
+    bool Find(int key);
+    void Clear();
+    std::vector<int> GetVector();
+    size_t Height();
+    size_t MemoryUsage();
+
+private:
+
+    enum class Color : unsigned char { Black, Red };
+
+    struct Node
+    {
+        Node* left;
+        Node* right;
+        int key;
+        Color color;
+
+        Node();
+        Node(int key);
+    };
+
+    Node* NewNode(int key);
+    void DeleteNode(Node* node);
+    void DeleteNodesRecursively(Node* node);
+
+    static bool IsRed(Node* node);
+    static Node*& Child(Node* node, bool right);
+    Node* RotateSingle(Node* p, bool right);
+    Node* RotateDouble(Node* p, bool right);
+    void InsertNode(int key);
+    void RemoveNode(int key);
+    Node* FindNode(int key);
+
+    void GetVector(Node* node, std::vector<int>& vec);
+    size_t Height(Node* node);
+    size_t Size(Node* node);
+
+    Node* root = nullptr;
+};
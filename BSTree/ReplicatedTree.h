@@ -0,0 +1,204 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+#include "NumaTopology.h"
+
+// Tree replicated per NUMA node in the style of node replication. Writers
+// update the primary tree and append to a shared operation log; every replica
+// replays the log lazily, so a Find touches only the replica of its own node.
+// Nodes of a replica are allocated by threads of that node replaying the log,
+// so first-touch keeps them in local memory.
+// T is RBTree or AVLTreeIterative (anything with Insert/Remove/Find/GetVector).
+template <typename T>
+class ReplicatedTree
+{
+public:
+    // numReplicas 0 means one replica per NUMA node
+    ReplicatedTree(size_t numReplicas = 0, size_t logCapacity = 1 << 16);
+
+    // safe to call from any number of threads
+    void Insert(int key);
+    void Remove(int key);
+    bool Find(int key);
+    // Find on a given replica instead of the local one
+    bool Find(int key, size_t replica);
+    // content of primary tree
+    std::vector<int> GetVector();
+    // content of replica after it caught up with the log
+    std::vector<int> GetVector(size_t replica);
+    size_t NumReplicas() const;
+    // number of log entries replayed by all replicas
+    size_t Replayed() const;
+
+private:
+
+    enum class Operation : int { Insert, Remove };
+
+    struct LogEntry
+    {
+        int key;
+        Operation operation;
+    };
+
+    // allocated separately, so replicas don't share cache lines
+    struct Replica
+    {
+        T tree;
+        std::shared_timed_mutex mutex;
+        // log entries before this index are applied to tree
+        std::atomic<size_t> applied{ 0 };
+    };
+
+    void Append(int key, Operation operation);
+    void Replay(Replica& replica, size_t tail);
+    size_t LocalReplica() const;
+
+    NumaTopology topology;
+    std::vector<std::unique_ptr<Replica>> replicas;
+    std::vector<LogEntry> log;
+    std::atomic<size_t> logTail;
+    std::atomic<size_t> replayed;
+    // guards primary and log appends
+    std::mutex writeMutex;
+    T primary;
+};
+
+template <typename T>
+ReplicatedTree<T>::ReplicatedTree(size_t numReplicas, size_t logCapacity) :
+    log(logCapacity),
+    logTail{ 0 },
+    replayed{ 0 }
+{
+    if (numReplicas == 0)
+    {
+        numReplicas = topology.NumNodes();
+    }
+    for (size_t i = 0; i < numReplicas; i++)
+    {
+        replicas.emplace_back(new Replica);
+    }
+}
+
+template <typename T>
+void ReplicatedTree<T>::Insert(int key)
+{
+    Append(key, Operation::Insert);
+}
+
+template <typename T>
+void ReplicatedTree<T>::Remove(int key)
+{
+    Append(key, Operation::Remove);
+}
+
+template <typename T>
+bool ReplicatedTree<T>::Find(int key)
+{
+    return Find(key, LocalReplica());
+}
+
+template <typename T>
+bool ReplicatedTree<T>::Find(int key, size_t replica)
+{
+    Replica& r = *replicas[replica];
+    // the replica must include every write completed before this Find started
+    size_t tail = logTail.load(std::memory_order_acquire);
+    if (r.applied.load(std::memory_order_acquire) < tail)
+    {
+        Replay(r, tail);
+    }
+    std::shared_lock<std::shared_timed_mutex> lock(r.mutex);
+    return r.tree.Find(key);
+}
+
+template <typename T>
+std::vector<int> ReplicatedTree<T>::GetVector()
+{
+    std::lock_guard<std::mutex> lock(writeMutex);
+    return primary.GetVector();
+}
+
+template <typename T>
+std::vector<int> ReplicatedTree<T>::GetVector(size_t replica)
+{
+    Replica& r = *replicas[replica];
+    Replay(r, logTail.load(std::memory_order_acquire));
+    std::shared_lock<std::shared_timed_mutex> lock(r.mutex);
+    return r.tree.GetVector();
+}
+
+template <typename T>
+size_t ReplicatedTree<T>::NumReplicas() const
+{
+    return replicas.size();
+}
+
+template <typename T>
+size_t ReplicatedTree<T>::Replayed() const
+{
+    return replayed.load(std::memory_order_relaxed);
+}
+
+template <typename T>
+void ReplicatedTree<T>::Append(int key, Operation operation)
+{
+    std::lock_guard<std::mutex> lock(writeMutex);
+    size_t tail = logTail.load(std::memory_order_relaxed);
+    // log is full, bring lagging replicas up to date before overwriting their entries
+    for (auto& replica : replicas)
+    {
+        if (tail - replica->applied.load(std::memory_order_acquire) >= log.size())
+        {
+            Replay(*replica, tail);
+        }
+    }
+    log[tail % log.size()] = LogEntry{ key, operation };
+    logTail.store(tail + 1, std::memory_order_release);
+
+    if (operation == Operation::Insert)
+    {
+        primary.Insert(key);
+    }
+    else
+    {
+        primary.Remove(key);
+    }
+}
+
+// apply log entries up to tail, whichever thread gets here first does the work
+template <typename T>
+void ReplicatedTree<T>::Replay(Replica& replica, size_t tail)
+{
+    std::unique_lock<std::shared_timed_mutex> lock(replica.mutex);
+    size_t start = replica.applied.load(std::memory_order_relaxed);
+    for (size_t i = start; i < tail; i++)
+    {
+        const LogEntry& entry = log[i % log.size()];
+        if (entry.operation == Operation::Insert)
+        {
+            replica.tree.Insert(entry.key);
+        }
+        else
+        {
+            replica.tree.Remove(entry.key);
+        }
+    }
+    if (tail > start)
+    {
+        replayed.fetch_add(tail - start, std::memory_order_relaxed);
+        // entries before tail may be overwritten from now on
+        replica.applied.store(tail, std::memory_order_release);
+    }
+}
+
+// with more replicas than nodes (for testing) nodes share them round robin
+template <typename T>
+size_t ReplicatedTree<T>::LocalReplica() const
+{
+    return topology.CurrentNode() % replicas.size();
+}
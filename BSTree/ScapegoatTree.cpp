@@ -0,0 +1,288 @@
+#include "ScapegoatTree.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+
+ScapegoatTree::Node::Node(int key) :
+    key{ key },
+    left{ nullptr },
+    right{ nullptr }
+{
+}
+
+ScapegoatTree::Node::~Node()
+{
+    delete left;
+    delete right;
+}
+
+ScapegoatTree::ScapegoatTree(double alpha) :
+    alpha{ alpha },
+    size{ 0 },
+    maxSize{ 0 },
+    root{ nullptr }
+{
+    assert(alpha > 0.5 && alpha < 1.0);
+}
+
+ScapegoatTree::~ScapegoatTree()
+{
+    delete root;
+}
+
+int ScapegoatTree::Height()
+{
+    return Height(root);
+}
+
+void ScapegoatTree::Insert(int key)
+{
+    // go down and remember links to the insertion position
+    path.clear();
+    Node** link = &root;
+    while (*link != nullptr)
+    {
+        if (key == (*link)->key)
+        {
+            return;
+        }
+        path.push_back(link);
+        if (key < (*link)->key)
+        {
+            link = &(*link)->left;
+        }
+        else
+        {
+            link = &(*link)->right;
+        }
+    }
+    *link = new Node(key);
+    size++;
+    maxSize = std::max(maxSize, size);
+
+    if (path.size() <= MaxDepth(size))
+    {
+        return;
+    }
+
+    // go up and find the scapegoat: the first ancestor that is not alpha-weight-balanced
+    Node* child = *link;
+    size_t childSize = 1;
+    for (size_t i = path.size(); i-- > 0;)
+    {
+        Node* node = *path[i];
+        Node* sibling = node->left == child ? node->right : node->left;
+        size_t nodeSize = childSize + Size(sibling) + 1;
+        if (childSize > alpha * nodeSize)
+        {
+            Rebuild(*path[i], nodeSize);
+            return;
+        }
+        child = node;
+        childSize = nodeSize;
+    }
+}
+
+void ScapegoatTree::Remove(int key)
+{
+    Node** link = &root;
+    while (*link != nullptr && (*link)->key != key)
+    {
+        if (key < (*link)->key)
+        {
+            link = &(*link)->left;
+        }
+        else
+        {
+            link = &(*link)->right;
+        }
+    }
+    Node* node = *link;
+    if (node == nullptr)
+    {
+        return;
+    }
+
+    // exclude node, replacing it by min of its right subtree
+    if (node->left == nullptr)
+    {
+        *link = node->right;
+    }
+    else if (node->right == nullptr)
+    {
+        *link = node->left;
+    }
+    else
+    {
+        Node** minLink = &node->right;
+        while ((*minLink)->left != nullptr)
+        {
+            minLink = &(*minLink)->left;
+        }
+        Node* min = *minLink;
+        *minLink = min->right;
+        min->left = node->left;
+        min->right = node->right;
+        *link = min;
+    }
+    node->left = nullptr;
+    node->right = nullptr;
+    delete node;
+    size--;
+
+    // rebuild the whole tree when too many nodes were removed
+    if (size < alpha * maxSize)
+    {
+        Rebuild(root, size);
+        maxSize = size;
+    }
+}
+
+bool ScapegoatTree::Find(int key)
+{
+    Node* node = root;
+    while (node != nullptr)
+    {
+        if (node->key == key)
+        {
+            return true;
+        }
+        if (key < node->key)
+        {
+            node = node->left;
+        }
+        else
+        {
+            node = node->right;
+        }
+    }
+    return false;
+}
+
+void ScapegoatTree::Clear()
+{
+    delete root;
+    root = nullptr;
+    size = 0;
+    maxSize = 0;
+}
+
+void ScapegoatTree::Print()
+{
+    Print(root);
+}
+
+std::vector<int> ScapegoatTree::GetVector()
+{
+    std::vector<int> values;
+    GetVector(root, values);
+    return values;
+}
+
+size_t ScapegoatTree::MemoryUsage()
+{
+    return size * sizeof(Node);
+}
+
+int ScapegoatTree::Height(Node* node)
+{
+    if (node == nullptr)
+    {
+        return 0;
+    }
+    return std::max(Height(node->left), Height(node->right)) + 1;
+}
+
+size_t ScapegoatTree::Size(Node* node)
+{
+    if (node == nullptr)
+    {
+        return 0;
+    }
+    return Size(node->left) + Size(node->right) + 1;
+}
+
+size_t ScapegoatTree::MaxDepth(size_t size)
+{
+    return static_cast<size_t>(std::log(static_cast<double>(size)) / std::log(1.0 / alpha));
+}
+
+// Day-Stout-Warren rebuild: flatten subtree into a right vine with rotations,
+// then fold the vine back into a complete tree. Linear time, no extra memory.
+void ScapegoatTree::Rebuild(Node*& node, size_t size)
+{
+    Node pseudoRoot(0);
+    pseudoRoot.right = node;
+
+    // tree to vine
+    Node* tail = &pseudoRoot;
+    Node* rest = tail->right;
+    while (rest != nullptr)
+    {
+        if (rest->left == nullptr)
+        {
+            tail = rest;
+            rest = rest->right;
+        }
+        else
+        {
+            Node* q = rest->left;
+            rest->left = q->right;
+            q->right = rest;
+            rest = q;
+            tail->right = q;
+        }
+    }
+
+    // vine to tree
+    size_t fullSize = 1;
+    while (fullSize <= size + 1)
+    {
+        fullSize <<= 1;
+    }
+    fullSize = (fullSize >> 1) - 1;
+    Compress(&pseudoRoot, size - fullSize);
+    for (size_t count = fullSize / 2; count > 0; count /= 2)
+    {
+        Compress(&pseudoRoot, count);
+    }
+
+    node = pseudoRoot.right;
+    pseudoRoot.right = nullptr;
+}
+
+void ScapegoatTree::Compress(Node* node, size_t count)
+{
+    Node* scanner = node;
+    for (size_t i = 0; i < count; i++)
+    {
+        Node* child = scanner->right;
+        scanner->right = child->right;
+        scanner = scanner->right;
+        child->right = scanner->left;
+        scanner->left = child;
+    }
+}
+
+void ScapegoatTree::Print(Node* node)
+{
+    if (node == nullptr)
+    {
+        return;
+    }
+    Print(node->left);
+    std::cout << node->key << " ";
+    Print(node->right);
+}
+
+void ScapegoatTree::GetVector(Node* node, std::vector<int>& vec)
+{
+    if (node == nullptr)
+    {
+        return;
+    }
+    GetVector(node->left, vec);
+    vec.push_back(node->key);
+    GetVector(node->right, vec);
+}
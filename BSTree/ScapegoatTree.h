@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Scapegoat tree: nodes keep only key and child links, balance is restored
+// by rebuilding the subtree of a scapegoat node into a perfectly balanced one.
+// alpha in (0.5, 1) trades lookup depth (smaller) against rebuild work (larger).
+class ScapegoatTree
+{
+public:
+
+    ScapegoatTree(double alpha = 0.7);
+    ~ScapegoatTree();
+    void Insert(int key);
+    void Remove(int key);
+    bool Find(int key);
+    int Height();
+    void Clear();
+    void Print();
+    std::vector<int> GetVector();
+    size_t MemoryUsage();
+
+private:
+
+    struct Node
+    {
+        int key;
+        Node* left;
+        Node* right;
+
+        Node(int key);
+        ~Node();
+    };
+
+    int Height(Node* node);
+    size_t Size(Node* node);
+    size_t MaxDepth(size_t size);
+    void Rebuild(Node*& node, size_t size);
+    void Compress(Node* node, size_t count);
+    void Print(Node* node);
+    void GetVector(Node* node, std::vector<int>& vec);
+
+    double alpha;
+    size_t size;
+    size_t maxSize;
+    Node* root;
+    std::vector<Node**> path;
+};
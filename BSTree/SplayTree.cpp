@@ -0,0 +1,264 @@
+#include "SplayTree.h"
+#include <algorithm>
+#include <utility>
+
+SplayTree::Node::Node(int key) :
+    left{ nullptr },
+    right{ nullptr },
+    key{ key }
+{
+}
+
+SplayTree::SplayTree()
+{
+}
+
+SplayTree::~SplayTree()
+{
+    DeleteNodes(root);
+}
+
+// Splay tree may degrade to a long path, so the whole-tree walks below
+// are iterative instead of recursive.
+void SplayTree::DeleteNodes(Node* node)
+{
+    while (node != nullptr)
+    {
+        if (node->left != nullptr)
+        {
+            // rotate right until there is no left child
+            Node* q = node->left;
+            node->left = q->right;
+            q->right = node;
+            node = q;
+        }
+        else
+        {
+            Node* right = node->right;
+            delete node;
+            node = right;
+        }
+    }
+}
+
+// Sleator-Tarjan top-down splay: returns new root, which is key's node
+// if key is present, or the last node on the search path otherwise.
+SplayTree::Node* SplayTree::Splay(Node* node, int key)
+{
+    if (node == nullptr)
+    {
+        return nullptr;
+    }
+
+    // left and right trees are collected under the header node
+    Node header(0);
+    Node* l = &header;
+    Node* r = &header;
+
+    while (true)
+    {
+        if (key < node->key)
+        {
+            if (node->left == nullptr)
+            {
+                break;
+            }
+            if (key < node->left->key)
+            {
+                // zig-zig: rotate right
+                Node* q = node->left;
+                node->left = q->right;
+                q->right = node;
+                node = q;
+                if (node->left == nullptr)
+                {
+                    break;
+                }
+            }
+            // link right
+            r->left = node;
+            r = node;
+            node = node->left;
+        }
+        else if (key > node->key)
+        {
+            if (node->right == nullptr)
+            {
+                break;
+            }
+            if (key > node->right->key)
+            {
+                // zig-zig: rotate left
+                Node* q = node->right;
+                node->right = q->left;
+                q->left = node;
+                node = q;
+                if (node->right == nullptr)
+                {
+                    break;
+                }
+            }
+            // link left
+            l->right = node;
+            l = node;
+            node = node->right;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    // assemble
+    l->right = node->left;
+    r->left = node->right;
+    node->left = header.right;
+    node->right = header.left;
+    return node;
+}
+
+void SplayTree::Insert(int key)
+{
+    if (root == nullptr)
+    {
+        root = new Node(key);
+        return;
+    }
+
+    root = Splay(root, key);
+    if (root->key == key)
+    {
+        return;
+    }
+
+    // split root around the new node
+    Node* node = new Node(key);
+    if (key < root->key)
+    {
+        node->left = root->left;
+        node->right = root;
+        root->left = nullptr;
+    }
+    else
+    {
+        node->right = root->right;
+        node->left = root;
+        root->right = nullptr;
+    }
+    root = node;
+}
+
+void SplayTree::Remove(int key)
+{
+    if (root == nullptr)
+    {
+        return;
+    }
+
+    root = Splay(root, key);
+    if (root->key != key)
+    {
+        return;
+    }
+
+    // join subtrees: max of left subtree has no right child after splay
+    Node* node = root;
+    if (node->left == nullptr)
+    {
+        root = node->right;
+    }
+    else
+    {
+        root = Splay(node->left, key);
+        root->right = node->right;
+    }
+    delete node;
+}
+
+bool SplayTree::Find(int key)
+{
+    root = Splay(root, key);
+    return root != nullptr && root->key == key;
+}
+
+size_t SplayTree::Depth(int key)
+{
+    size_t depth = 1;
+    Node* node = root;
+    while (node != nullptr)
+    {
+        if (node->key == key)
+        {
+            return depth;
+        }
+        node = key < node->key ? node->left : node->right;
+        depth++;
+    }
+    return 0;
+}
+
+void SplayTree::Clear()
+{
+    DeleteNodes(root);
+    root = nullptr;
+}
+
+void SplayTree::GetVector(Node* node, std::vector<int>& vec)
+{
+    std::vector<Node*> stack;
+    while (node != nullptr || !stack.empty())
+    {
+        while (node != nullptr)
+        {
+            stack.push_back(node);
+            node = node->left;
+        }
+        node = stack.back();
+        stack.pop_back();
+        vec.push_back(node->key);
+        node = node->right;
+    }
+}
+
+std::vector<int> SplayTree::GetVector()
+{
+    std::vector<int> values;
+    GetVector(root, values);
+    return values;
+}
+
+size_t SplayTree::Height()
+{
+    return Height(root);
+}
+
+size_t SplayTree::Height(Node* node)
+{
+    size_t height = 0;
+    std::vector<std::pair<Node*, size_t>> stack;
+    if (node != nullptr)
+    {
+        stack.emplace_back(node, 1);
+    }
+    while (!stack.empty())
+    {
+        Node* top = stack.back().first;
+        size_t depth = stack.back().second;
+        stack.pop_back();
+        height = std::max(height, depth);
+        if (top->left != nullptr)
+        {
+            stack.emplace_back(top->left, depth + 1);
+        }
+        if (top->right != nullptr)
+        {
+            stack.emplace_back(top->right, depth + 1);
+        }
+    }
+    return height;
+}
+
+size_t SplayTree::MemoryUsage()
+{
+    return GetVector().size() * sizeof(Node);
+}
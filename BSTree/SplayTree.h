@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Top-down splay tree: every access moves the accessed key to the root,
+// so frequently requested keys stay near the top for skewed workloads.
+class SplayTree
+{
+public:
+    SplayTree();
+    ~SplayTree();
+
+    void Insert(int key);
+    void Remove(int key);
+    bool Find(int key);
+    void Clear();
+    std::vector<int> GetVector();
+    size_t Height();
+    size_t MemoryUsage();
+    // depth of key (root is 1, 0 if absent) without splaying
+    size_t Depth(int key);
+
+private:
+
+    struct Node
+    {
+        Node* left;
+        Node* right;
+        int key;
+
+        Node(int key);
+    };
+
+    Node* Splay(Node* node, int key);
+    void DeleteNodes(Node* node);
+    void GetVector(Node* node, std::vector<int>& vec);
+    size_t Height(Node* node);
+
+    Node* root = nullptr;
+};
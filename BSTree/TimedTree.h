@@ -0,0 +1,183 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "AllocationCounter.h"
+#include "LatencyHistogram.h"
+
+// Records latency of sampled Insert, Remove and Find calls on a tree. Sampled
+// inserts and removes are also split by how far rebalancing went up, when T
+// counts it with RebalanceSteps() (RBTree, AVLTreeIterative), and every sampled
+// call by whether it allocated memory, when built with COUNT_ALLOCATIONS,
+// so spikes can be told apart.
+// T is any tree with Insert, Remove, Find, Clear, GetVector and MemoryUsage.
+template <typename T>
+class TimedTree
+{
+public:
+    enum class Operation { Insert, Remove, Find };
+    // rebalance depth classes: 0, 1, 2-3 and 4 or more steps
+    static const size_t depthClasses = 4;
+
+    // every samplePeriod-th call is timed, 1 times all of them
+    TimedTree(unsigned int samplePeriod = 1);
+
+    void Insert(int key);
+    void Remove(int key);
+    bool Find(int key);
+    void Clear();
+    std::vector<int> GetVector();
+    size_t MemoryUsage();
+
+    const LatencyHistogram& Latencies(Operation operation) const;
+    // empty for Find and when T doesn't count rebalance steps
+    const LatencyHistogram& RebalanceLatencies(Operation operation, size_t depthClass) const;
+    // empty without COUNT_ALLOCATIONS
+    const LatencyHistogram& AllocationLatencies(Operation operation, bool allocated) const;
+    void ResetLatencies();
+
+private:
+    template <typename Call> bool Timed(Operation operation, Call call);
+    size_t RebalanceSteps();
+    static size_t DepthClass(size_t steps);
+
+    T tree;
+    unsigned int samplePeriod;
+    unsigned int untilSample;
+    LatencyHistogram latencies[3];
+    LatencyHistogram rebalanceLatencies[3][depthClasses];
+    LatencyHistogram allocationLatencies[3][2];
+};
+
+template <typename T>
+TimedTree<T>::TimedTree(unsigned int samplePeriod) :
+    samplePeriod{ std::max(samplePeriod, 1u) },
+    untilSample{ std::max(samplePeriod, 1u) }
+{
+}
+
+template <typename T>
+void TimedTree<T>::Insert(int key)
+{
+    Timed(Operation::Insert, [this, key]() { tree.Insert(key); return false; });
+}
+
+template <typename T>
+void TimedTree<T>::Remove(int key)
+{
+    Timed(Operation::Remove, [this, key]() { tree.Remove(key); return false; });
+}
+
+template <typename T>
+bool TimedTree<T>::Find(int key)
+{
+    return Timed(Operation::Find, [this, key]() { return tree.Find(key); });
+}
+
+template <typename T>
+void TimedTree<T>::Clear()
+{
+    tree.Clear();
+}
+
+template <typename T>
+std::vector<int> TimedTree<T>::GetVector()
+{
+    return tree.GetVector();
+}
+
+template <typename T>
+size_t TimedTree<T>::MemoryUsage()
+{
+    return tree.MemoryUsage();
+}
+
+template <typename T>
+const LatencyHistogram& TimedTree<T>::Latencies(Operation operation) const
+{
+    return latencies[static_cast<size_t>(operation)];
+}
+
+template <typename T>
+const LatencyHistogram& TimedTree<T>::RebalanceLatencies(Operation operation, size_t depthClass) const
+{
+    return rebalanceLatencies[static_cast<size_t>(operation)][depthClass];
+}
+
+template <typename T>
+const LatencyHistogram& TimedTree<T>::AllocationLatencies(Operation operation, bool allocated) const
+{
+    return allocationLatencies[static_cast<size_t>(operation)][allocated ? 1 : 0];
+}
+
+template <typename T>
+void TimedTree<T>::ResetLatencies()
+{
+    for (size_t i = 0; i < 3; i++)
+    {
+        latencies[i].Clear();
+        for (LatencyHistogram& histogram : rebalanceLatencies[i])
+        {
+            histogram.Clear();
+        }
+        allocationLatencies[i][0].Clear();
+        allocationLatencies[i][1].Clear();
+    }
+    untilSample = samplePeriod;
+}
+
+// counters are read outside the timed interval, so they add nothing to it
+template <typename T>
+template <typename Call>
+bool TimedTree<T>::Timed(Operation operation, Call call)
+{
+    if (--untilSample != 0)
+    {
+        return call();
+    }
+    untilSample = samplePeriod;
+
+    size_t steps = RebalanceSteps();
+    size_t allocations = AllocationCount();
+    uint64_t start = LatencyHistogram::Now();
+    bool result = call();
+    uint64_t ticks = LatencyHistogram::Now() - start;
+    steps = RebalanceSteps() - steps;
+    allocations = AllocationCount() - allocations;
+
+    size_t i = static_cast<size_t>(operation);
+    latencies[i].Record(ticks);
+    if (AllocationsCounted())
+    {
+        allocationLatencies[i][allocations > 0 ? 1 : 0].Record(ticks);
+    }
+    if constexpr (requires { tree.RebalanceSteps(); })
+    {
+        if (operation != Operation::Find)
+        {
+            rebalanceLatencies[i][DepthClass(steps)].Record(ticks);
+        }
+    }
+    return result;
+}
+
+template <typename T>
+size_t TimedTree<T>::RebalanceSteps()
+{
+    if constexpr (requires { tree.RebalanceSteps(); })
+    {
+        return tree.RebalanceSteps();
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+template <typename T>
+size_t TimedTree<T>::DepthClass(size_t steps)
+{
+    return steps < 2 ? steps : (steps < 4 ? 2 : 3);
+}
@@ -0,0 +1,99 @@
+#include "TransactionalRBTree.h"
+#include <algorithm>
+#include <mutex>
+
+void TransactionalRBTree::Transaction::Insert(int key)
+{
+    operations.emplace_back(key, true);
+}
+
+void TransactionalRBTree::Transaction::Remove(int key)
+{
+    operations.emplace_back(key, false);
+}
+
+size_t TransactionalRBTree::Transaction::Size() const
+{
+    return operations.size();
+}
+
+void TransactionalRBTree::Transaction::Clear()
+{
+    operations.clear();
+}
+
+void TransactionalRBTree::Insert(int key)
+{
+    std::unique_lock<std::shared_timed_mutex> lock(mutex);
+    tree.Insert(key);
+}
+
+void TransactionalRBTree::Remove(int key)
+{
+    std::unique_lock<std::shared_timed_mutex> lock(mutex);
+    tree.Remove(key);
+}
+
+bool TransactionalRBTree::Find(int key)
+{
+    std::shared_lock<std::shared_timed_mutex> lock(mutex);
+    return tree.Find(key);
+}
+
+void TransactionalRBTree::Commit(Transaction& transaction)
+{
+    // sort and dedup outside of the lock, stable sort keeps order of operations on the same key
+    std::vector<std::pair<int, bool>>& operations = transaction.operations;
+    std::stable_sort(operations.begin(), operations.end(), [](const std::pair<int, bool>& a, const std::pair<int, bool>& b)
+    {
+        return a.first < b.first;
+    });
+
+    // only the last operation on a key matters
+    std::vector<int> removeKeys;
+    std::vector<int> insertKeys;
+    for (size_t i = 0; i < operations.size(); i++)
+    {
+        if (i + 1 < operations.size() && operations[i + 1].first == operations[i].first)
+        {
+            continue;
+        }
+        if (operations[i].second)
+        {
+            insertKeys.push_back(operations[i].first);
+        }
+        else
+        {
+            removeKeys.push_back(operations[i].first);
+        }
+    }
+
+    std::unique_lock<std::shared_timed_mutex> lock(mutex);
+    // keys are distinct, so removes and inserts don't interfere
+    for (int key : removeKeys)
+    {
+        tree.Remove(key);
+    }
+    tree.InsertSorted(insertKeys);
+    lock.unlock();
+
+    transaction.Clear();
+}
+
+void TransactionalRBTree::Clear()
+{
+    std::unique_lock<std::shared_timed_mutex> lock(mutex);
+    tree.Clear();
+}
+
+std::vector<int> TransactionalRBTree::GetVector()
+{
+    std::shared_lock<std::shared_timed_mutex> lock(mutex);
+    return tree.GetVector();
+}
+
+size_t TransactionalRBTree::Height()
+{
+    std::shared_lock<std::shared_timed_mutex> lock(mutex);
+    return tree.Height();
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+#include "RBTree.h"
+
+// RBTree shared between threads: readers hold a shared lock, writers an
+// exclusive one. A Transaction buffers inserts and removes and Commit applies
+// them all under one exclusive lock, so readers see either none or all of them.
+class TransactionalRBTree
+{
+public:
+
+    class Transaction
+    {
+    public:
+        void Insert(int key);
+        void Remove(int key);
+        size_t Size() const;
+        void Clear();
+
+    private:
+        friend class TransactionalRBTree;
+
+        // key and whether it is inserted, in order of calls
+        std::vector<std::pair<int, bool>> operations;
+    };
+
+    void Insert(int key);
+    void Remove(int key);
+    bool Find(int key);
+    // apply all operations of transaction atomically and clear it
+    void Commit(Transaction& transaction);
+    void Clear();
+    std::vector<int> GetVector();
+    size_t Height();
+
+private:
+    RBTree tree;
+    std::shared_timed_mutex mutex;
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+// Zipfian distribution over ranks [0, n): P(rank) ~ 1 / (rank + 1)^s.
+// Rank 0 is the hottest one.
+class ZipfDistribution
+{
+public:
+    ZipfDistribution(size_t n, double s = 0.99) :
+        cdf(n)
+    {
+        double sum = 0.0;
+        for (size_t i = 0; i < n; i++)
+        {
+            sum += 1.0 / std::pow(static_cast<double>(i + 1), s);
+            cdf[i] = sum;
+        }
+        for (double& value : cdf)
+        {
+            value /= sum;
+        }
+    }
+
+    template <typename Generator> size_t operator()(Generator& gen)
+    {
+        double u = uniform(gen);
+        size_t rank = std::lower_bound(cdf.cbegin(), cdf.cend(), u) - cdf.cbegin();
+        return std::min(rank, cdf.size() - 1);
+    }
+
+private:
+    std::vector<double> cdf;
+    std::uniform_real_distribution<double> uniform;
+};
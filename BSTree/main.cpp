@@ -1,155 +1,1766 @@
-#include <iostream>
-#include <iomanip>
-#include <random>
-#include <set>
-#include <vector>
-#include <chrono>
-#include <algorithm>
-#include <string>
-
-#include "AVLTree.h"
-#include "AVLTreeIterative.h"
-#include "RBTree.h"
-
-template <typename T> inline void Insert(T& tree, int value);
-template <> inline void Insert<std::set<int>>(std::set<int>& tree, int value);
-template <typename T> inline void Remove(T& tree, int value);
-template <> inline void Remove<std::set<int>>(std::set<int>& tree, int value);
-
-template <typename T> void TestTreeTiming(T& tree, std::vector<int>& keys, std::pair<double, double>& times);
-template <typename T> void PrepareSomeTree(T& tree, std::vector<int>& keys);
-template <typename T> void CheckEquality(T& tree, std::set<int>& controlSet, const char* name);
-
-int main()
-{
-	const int maxValue = 10'000'000;
-	const int insertSize = 1'000'000;
-	const int numTests = 1;
-
-	std::random_device rd;
-	std::default_random_engine gen(rd());
-	std::uniform_int_distribution<int> dist(0, maxValue);
-
-	std::vector<int> insertKeys;
-	insertKeys.reserve(insertSize);
-	for (int i = 0; i < insertSize; i++)
-	{
-		int rndInt = dist(gen);
-		insertKeys.push_back(rndInt);
-	}
-
-	// test insert/remove timings
-	std::pair<double, double> stdTimes;
-	std::pair<double, double> avlRecTimes;
-	std::pair<double, double> avlIterTimes;
-	std::pair<double, double> rbTimes;
-
-	for (int n = 0; n < numTests; n++)
-	{
-		std::set<int> stdSet;
-		AVLTree avlRec;
-		AVLTreeIterative avlIter;
-		RBTree rb;
-
-		TestTreeTiming(stdSet, insertKeys, stdTimes);
-		TestTreeTiming(avlRec, insertKeys, avlRecTimes);
-		TestTreeTiming(avlIter, insertKeys, avlIterTimes);
-		TestTreeTiming(rb, insertKeys, rbTimes);
-	}
-
-	stdTimes.first /= numTests;
-	stdTimes.second /= numTests;
-	avlRecTimes.first /= numTests;
-	avlRecTimes.second /= numTests;
-	avlIterTimes.first /= numTests;
-	avlIterTimes.second /= numTests;
-	rbTimes.first /= numTests;
-	rbTimes.second /= numTests;
-
-	std::cout << "Test insert/remove with " << insertSize << " elements" << '\n';
-	std::cout << std::left << std::setw(10) << "tree" << std::setw(20) << "insert, ms" << std::setw(20) << "remove, ms" << '\n';
-	std::cout << std::left << std::setw(10) << "std::set" << std::setw(20) << stdTimes.first << std::setw(20) << stdTimes.second << '\n';
-	std::cout << std::left << std::setw(10) << "avlRec" << std::setw(20) << avlRecTimes.first << std::setw(20) << avlRecTimes.second << '\n';
-	std::cout << std::left << std::setw(10) << "avlIter" << std::setw(20) << avlIterTimes.first << std::setw(20) << avlIterTimes.second << '\n';
-	std::cout << std::left << std::setw(10) << "rb" << std::setw(20) << rbTimes.first << std::setw(20) << rbTimes.second << '\n';
-
-	// test equality with std::set
-	std::set<int> controlSet;
-	AVLTree avlRec;
-	AVLTreeIterative avlIter;
-	RBTree rb;
-
-	PrepareSomeTree(controlSet, insertKeys);
-	PrepareSomeTree(avlRec, insertKeys);
-	PrepareSomeTree(avlIter, insertKeys);
-	PrepareSomeTree(rb, insertKeys);
-
-	CheckEquality(avlRec, controlSet, "avlRec");
-	CheckEquality(avlIter, controlSet, "avlIter");
-	CheckEquality(rb, controlSet, "rb");
-}
-
-template <typename T> void TestTreeTiming(T& tree, std::vector<int>& keys, std::pair<double, double>& times)
-{
-	double insertTime = 0.0;
-	double removeTime = 0.0;
-	std::chrono::high_resolution_clock::time_point t1, t2;
-
-	t1 = std::chrono::high_resolution_clock::now();
-	for (auto& value : keys)
-	{
-		Insert(tree, value);
-	}
-	t2 = std::chrono::high_resolution_clock::now();
-	insertTime += std::chrono::duration<double, std::milli>(t2 - t1).count();
-
-	t1 = std::chrono::high_resolution_clock::now();
-	for (auto& value : keys)
-	{
-		Remove(tree, value);
-	}
-	t2 = std::chrono::high_resolution_clock::now();
-	removeTime += std::chrono::duration<double, std::milli>(t2 - t1).count();
-
-	times.first += insertTime;
-	times.second += removeTime;
-}
-
-template <typename T> void CheckEquality(T& tree, std::set<int>& controlSet, const char* name)
-{
-	std::vector<int> treeValues = tree.GetVector();
-	bool isEqual = std::equal(treeValues.cbegin(), treeValues.cend(), controlSet.cbegin());
-	std::cout << "Are " << name << " and std::set equal? " << (isEqual ? "yes" : "no") << '\n';
-}
-
-template <typename T> inline void Insert(T& tree, int value)
-{
-	tree.Insert(value);
-}
-
-template <> inline void Insert<std::set<int>>(std::set<int>& tree, int value)
-{
-	tree.insert(value);
-}
-
-template <typename T> inline void Remove(T& tree, int value)
-{
-	tree.Remove(value);
-}
-
-template <> inline void Remove<std::set<int>>(std::set<int>& tree, int value)
-{
-	tree.erase(value);
-}
-
-template <typename T> void PrepareSomeTree(T& tree, std::vector<int>& keys)
-{
-	for (int value : keys)
-	{
-		Insert(tree, value);
-	}
-	for (size_t i = 0; i < keys.size(); i += 2)
-	{
-		Remove(tree, keys[i]);
-	}
-}
\ No newline at end of file
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <set>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <string>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <coroutine>
+#include <exception>
+#include <sstream>
+#include <cmath>
+
+#include "AVLTree.h"
+#include "AVLTreeIterative.h"
+#include "AVLTreeHotCold.h"
+#include "BitmapSet.h"
+#include "AdaptiveRadixTree.h"
+#include "BEpsilonTree.h"
+#include "LSMTree.h"
+#include "RBTree.h"
+#include "RBTreeTopDown.h"
+#include "ScapegoatTree.h"
+#include "SplayTree.h"
+#include "ZipfDistribution.h"
+#include "CachedTree.h"
+#include "FilteredTree.h"
+#include "IntervalTree.h"
+#include "AugmentedTree.h"
+#include "ConcurrentAVLTree.h"
+#include "TransactionalRBTree.h"
+#include "ReplicatedTree.h"
+#include "TimedTree.h"
+#include "PerfCounters.h"
+#include "BatchExecutor.h"
+
+template <typename T> inline void Insert(T& tree, int value);
+template <> inline void Insert<std::set<int>>(std::set<int>& tree, int value);
+template <typename T> inline void Remove(T& tree, int value);
+template <> inline void Remove<std::set<int>>(std::set<int>& tree, int value);
+template <typename T> inline bool Find(T& tree, int value);
+template <> inline bool Find<std::set<int>>(std::set<int>& tree, int value);
+
+template <typename T> void TestTreeTiming(T& tree, std::vector<int>& keys, std::pair<double, double>& times);
+template <typename T> void PrepareSomeTree(T& tree, std::vector<int>& keys);
+template <typename T> void CheckEquality(T& tree, std::set<int>& controlSet, const char* name);
+template <typename T> bool CheckEmptiedTree(std::vector<int>& keys);
+template <typename T> void TestCounterTiming(std::vector<int>& keys, const char* name);
+template <typename T> void TestFindTiming(std::vector<int>& keys, std::vector<int>& probes, const char* name);
+template <typename T> void TestSkewedFindTiming(std::vector<int>& keys, std::vector<int>& uniformProbes, std::vector<int>& zipfProbes, const char* name);
+template <typename T> void TestCachedFindTiming(std::vector<int>& keys, std::vector<int>& uniformProbes, std::vector<int>& zipfProbes, const char* name);
+template <typename T> double FindTiming(T& tree, std::vector<int>& probes);
+template <typename T> void TestRangeTiming(std::vector<int>& keys, std::vector<int>& rangeKeys, const char* name);
+template <typename T> void TestNearestTiming(std::vector<int>& keys, std::vector<int>& probes, std::vector<int>& sortedProbes, const char* name);
+void TestIntervalTree(std::vector<int>& keys, std::default_random_engine& gen);
+template <template <typename> class Tree> void TestAggregate(std::vector<int>& keys, std::default_random_engine& gen, const char* name);
+void TestMultiset(size_t numKeys, int distinctKeys, std::default_random_engine& gen);
+bool StressConcurrentTree(int numThreads, int opsPerThread, int keyRange);
+void TestConcurrentTiming(std::vector<int>& keys, std::vector<int>& probes);
+void TestTransactions(std::vector<int>& keys, std::vector<int>& probes);
+bool CheckTransactionAtomicity(int numTransactions);
+template <typename T> bool StressReplicatedTree(size_t numReplicas, size_t logCapacity, int opsPerThread, int keyRange);
+template <typename T> void TestReplicatedTiming(std::vector<int>& keys, std::vector<int>& probes, const char* name);
+template <typename T> bool TestBatchFindTiming(std::vector<int>& keys, std::vector<int>& probes, const char* name);
+template <typename T> bool TestBuildTiming(std::vector<int>& keys, std::set<int>& controlSet, unsigned int threads, const char* name);
+template <typename T> void TestCompactTiming(std::vector<int>& keys, std::vector<int>& churnKeys, std::vector<int>& probes, const char* name);
+template <typename T> void TestHugePageTiming(std::vector<int>& keys, std::vector<int>& probes, const char* name);
+template <typename T> bool TestMixedTiming(std::vector<int>& keys, std::vector<int>& opKeys, int writePercent, const char* name);
+template <typename T> bool TestNearTiming(std::vector<int>& keys, const char* name);
+template <typename T> void TestLatencyTiming(std::vector<int>& keys, const char* name);
+template <typename T> void TestLatencyAttribution(std::vector<int>& keys, const char* name);
+template <typename T, typename InsertOp, typename CountOp, typename RemoveOp> double MultisetTiming(std::vector<int>& keys, std::vector<int>& probes, T& tree,
+	InsertOp insert, CountOp count, RemoveOp remove, std::pair<double, double>& times, size_t& checksum);
+template <typename T> double ConcurrentThroughput(T& tree, int numThreads, std::vector<int>& keys, std::vector<int>& probes, int writePercent);
+template <typename T> void RunTimedOps(TimedTree<T>& tree, std::vector<int>& keys);
+std::string LatencyShare(const LatencyHistogram& part, const LatencyHistogram& all);
+
+int main()
+{
+	const int maxValue = 10'000'000;
+	const int insertSize = 1'000'000;
+	const int findSize = 1'000'000;
+	const int numTests = 1;
+
+	std::random_device rd;
+	std::default_random_engine gen(rd());
+	std::uniform_int_distribution<int> dist(0, maxValue);
+
+	std::vector<int> insertKeys;
+	insertKeys.reserve(insertSize);
+	for (int i = 0; i < insertSize; i++)
+	{
+		int rndInt = dist(gen);
+		insertKeys.push_back(rndInt);
+	}
+
+	// test insert/remove timings
+	std::pair<double, double> stdTimes;
+	std::pair<double, double> avlRecTimes;
+	std::pair<double, double> avlIterTimes;
+	std::pair<double, double> avlHotColdTimes;
+	std::pair<double, double> rbTimes;
+	std::pair<double, double> rbTopDownTimes;
+	std::pair<double, double> scapegoatTimes;
+	std::pair<double, double> splayTimes;
+	std::pair<double, double> bitmapTimes;
+	std::pair<double, double> artTimes;
+	std::pair<double, double> bEpsilonTimes;
+
+	for (int n = 0; n < numTests; n++)
+	{
+		std::set<int> stdSet;
+		AVLTree avlRec;
+		AVLTreeIterative avlIter;
+		AVLTreeHotCold avlHotCold;
+		RBTree rb;
+		RBTreeTopDown rbTopDown;
+		ScapegoatTree scapegoat;
+		SplayTree splay;
+		BitmapSet bitmap;
+		AdaptiveRadixTree art;
+		BEpsilonTree bEpsilon;
+
+		TestTreeTiming(stdSet, insertKeys, stdTimes);
+		TestTreeTiming(avlRec, insertKeys, avlRecTimes);
+		TestTreeTiming(avlIter, insertKeys, avlIterTimes);
+		TestTreeTiming(avlHotCold, insertKeys, avlHotColdTimes);
+		TestTreeTiming(rb, insertKeys, rbTimes);
+		TestTreeTiming(rbTopDown, insertKeys, rbTopDownTimes);
+		TestTreeTiming(scapegoat, insertKeys, scapegoatTimes);
+		TestTreeTiming(splay, insertKeys, splayTimes);
+		TestTreeTiming(bitmap, insertKeys, bitmapTimes);
+		TestTreeTiming(art, insertKeys, artTimes);
+		TestTreeTiming(bEpsilon, insertKeys, bEpsilonTimes);
+	}
+
+	stdTimes.first /= numTests;
+	stdTimes.second /= numTests;
+	avlRecTimes.first /= numTests;
+	avlRecTimes.second /= numTests;
+	avlIterTimes.first /= numTests;
+	avlIterTimes.second /= numTests;
+	avlHotColdTimes.first /= numTests;
+	avlHotColdTimes.second /= numTests;
+	rbTimes.first /= numTests;
+	rbTimes.second /= numTests;
+	rbTopDownTimes.first /= numTests;
+	rbTopDownTimes.second /= numTests;
+	scapegoatTimes.first /= numTests;
+	scapegoatTimes.second /= numTests;
+	splayTimes.first /= numTests;
+	splayTimes.second /= numTests;
+	bitmapTimes.first /= numTests;
+	bitmapTimes.second /= numTests;
+	artTimes.first /= numTests;
+	artTimes.second /= numTests;
+	bEpsilonTimes.first /= numTests;
+	bEpsilonTimes.second /= numTests;
+
+	std::cout << "Test insert/remove with " << insertSize << " elements" << '\n';
+	std::cout << std::left << std::setw(10) << "tree" << std::setw(20) << "insert, ms" << std::setw(20) << "remove, ms" << '\n';
+	std::cout << std::left << std::setw(10) << "std::set" << std::setw(20) << stdTimes.first << std::setw(20) << stdTimes.second << '\n';
+	std::cout << std::left << std::setw(10) << "avlRec" << std::setw(20) << avlRecTimes.first << std::setw(20) << avlRecTimes.second << '\n';
+	std::cout << std::left << std::setw(10) << "avlIter" << std::setw(20) << avlIterTimes.first << std::setw(20) << avlIterTimes.second << '\n';
+	std::cout << std::left << std::setw(10) << "hotCold" << std::setw(20) << avlHotColdTimes.first << std::setw(20) << avlHotColdTimes.second << '\n';
+	std::cout << std::left << std::setw(10) << "rb" << std::setw(20) << rbTimes.first << std::setw(20) << rbTimes.second << '\n';
+	std::cout << std::left << std::setw(10) << "rbTopDown" << std::setw(20) << rbTopDownTimes.first << std::setw(20) << rbTopDownTimes.second << '\n';
+	std::cout << std::left << std::setw(10) << "scapegoat" << std::setw(20) << scapegoatTimes.first << std::setw(20) << scapegoatTimes.second << '\n';
+	std::cout << std::left << std::setw(10) << "splay" << std::setw(20) << splayTimes.first << std::setw(20) << splayTimes.second << '\n';
+	std::cout << std::left << std::setw(10) << "bitmap" << std::setw(20) << bitmapTimes.first << std::setw(20) << bitmapTimes.second << '\n';
+	std::cout << std::left << std::setw(10) << "art" << std::setw(20) << artTimes.first << std::setw(20) << artTimes.second << '\n';
+	std::cout << std::left << std::setw(10) << "bEpsilon" << std::setw(20) << bEpsilonTimes.first << std::setw(20) << bEpsilonTimes.second << '\n';
+
+	// test insert/find/remove with hardware counters, to tell why one tree is faster
+	std::cout << "Test insert/find/remove with " << insertSize << " elements, per operation" << '\n';
+	{
+		PerfCounters probe;
+		probe.Start();
+		probe.Stop();
+		if (!probe.Available(PerfCounters::Event::Cycles))
+		{
+			std::cout << "Hardware counters are not available (perf_event_open failed or not Linux), n/a is shown instead" << '\n';
+		}
+	}
+	std::cout << std::left << std::setw(10) << "tree" << std::setw(10) << "op" << std::setw(10) << "ns";
+	for (size_t i = 0; i < PerfCounters::eventCount; i++)
+	{
+		std::cout << std::setw(10) << PerfCounters::Name(static_cast<PerfCounters::Event>(i));
+	}
+	std::cout << '\n';
+	TestCounterTiming<std::set<int>>(insertKeys, "std::set");
+	TestCounterTiming<AVLTree>(insertKeys, "avlRec");
+	TestCounterTiming<AVLTreeIterative>(insertKeys, "avlIter");
+	TestCounterTiming<AVLTreeHotCold>(insertKeys, "hotCold");
+	TestCounterTiming<RBTree>(insertKeys, "rb");
+	TestCounterTiming<RBTreeTopDown>(insertKeys, "rbTopDown");
+
+	// test equality with std::set
+	std::set<int> controlSet;
+	AVLTree avlRec;
+	AVLTreeIterative avlIter;
+	AVLTreeHotCold avlHotCold;
+	RBTree rb;
+	RBTreeTopDown rbTopDown;
+	ScapegoatTree scapegoat;
+	SplayTree splay;
+	BitmapSet bitmap;
+	AdaptiveRadixTree art;
+	BEpsilonTree bEpsilon;
+	LSMTree lsm;
+
+	PrepareSomeTree(controlSet, insertKeys);
+	PrepareSomeTree(avlRec, insertKeys);
+	PrepareSomeTree(avlIter, insertKeys);
+	PrepareSomeTree(avlHotCold, insertKeys);
+	PrepareSomeTree(rb, insertKeys);
+	PrepareSomeTree(rbTopDown, insertKeys);
+	PrepareSomeTree(scapegoat, insertKeys);
+	PrepareSomeTree(splay, insertKeys);
+	PrepareSomeTree(bitmap, insertKeys);
+	PrepareSomeTree(art, insertKeys);
+	PrepareSomeTree(bEpsilon, insertKeys);
+	PrepareSomeTree(lsm, insertKeys);
+
+	CheckEquality(avlRec, controlSet, "avlRec");
+	CheckEquality(avlIter, controlSet, "avlIter");
+	CheckEquality(avlHotCold, controlSet, "hotCold");
+	CheckEquality(rb, controlSet, "rb");
+	CheckEquality(rbTopDown, controlSet, "rbTopDown");
+	CheckEquality(scapegoat, controlSet, "scapegoat");
+	CheckEquality(splay, controlSet, "splay");
+	CheckEquality(bitmap, controlSet, "bitmap");
+	CheckEquality(art, controlSet, "art");
+	CheckEquality(bEpsilon, controlSet, "bEpsilon");
+	CheckEquality(lsm, controlSet, "lsm");
+	// Find and Count on emptied trees, removes leave the rb sentinel's parent set and Clear keeps it
+	bool isEmptiedEqual = CheckEmptiedTree<RBTree>(insertKeys) && CheckEmptiedTree<AVLTreeIterative>(insertKeys);
+	std::cout << "Do trees emptied by Clear and Remove find nothing? " << (isEmptiedEqual ? "yes" : "no") << '\n';
+
+	// test insert and find of keys arriving in increasing and clustered order
+	std::vector<int> sequentialKeys;
+	std::vector<int> clusteredKeys;
+	sequentialKeys.reserve(insertSize);
+	clusteredKeys.reserve(insertSize);
+	int clusterBase = 0;
+	for (int i = 0; i < insertSize; i++)
+	{
+		sequentialKeys.push_back(2 * i);
+		// runs of 256 keys fall within 4096 of a random position
+		if (i % 256 == 0)
+		{
+			clusterBase = dist(gen);
+		}
+		clusteredKeys.push_back(clusterBase + static_cast<int>(gen() % 4096));
+	}
+	std::cout << "Test insert and find of " << insertSize << " sequential keys" << '\n';
+	std::cout << std::left << std::setw(10) << "tree" << std::setw(20) << "Insert, ms" << std::setw(20) << "InsertNear, ms" << std::setw(20) << "Find, ns" << std::setw(20) << "FindNear, ns" << '\n';
+	bool isNearEqual = TestNearTiming<AVLTreeIterative>(sequentialKeys, "avlIter");
+	isNearEqual = TestNearTiming<RBTree>(sequentialKeys, "rb") && isNearEqual;
+	std::cout << "Test insert and find of " << insertSize << " clustered keys" << '\n';
+	std::cout << std::left << std::setw(10) << "tree" << std::setw(20) << "Insert, ms" << std::setw(20) << "InsertNear, ms" << std::setw(20) << "Find, ns" << std::setw(20) << "FindNear, ns" << '\n';
+	isNearEqual = TestNearTiming<AVLTreeIterative>(clusteredKeys, "avlIter") && isNearEqual;
+	isNearEqual = TestNearTiming<RBTree>(clusteredKeys, "rb") && isNearEqual;
+	std::cout << "Do trees built with InsertNear and Insert agree? " << (isNearEqual ? "yes" : "no") << '\n';
+
+	// test latency percentiles of every insert, find and remove of insertSize keys
+	std::cout << "Test latency of insert, find and remove of " << insertSize << " keys, ns" << '\n';
+	std::cout << std::left << std::setw(10) << "tree" << std::setw(10) << "op" << std::setw(20) << "p50" << std::setw(20) << "p99" << std::setw(20) << "p99.9" << std::setw(20) << "max" << '\n';
+	TestLatencyTiming<AVLTree>(insertKeys, "avlRec");
+	TestLatencyTiming<AVLTreeIterative>(insertKeys, "avlIter");
+	TestLatencyTiming<AVLTreeHotCold>(insertKeys, "hotCold");
+	TestLatencyTiming<RBTree>(insertKeys, "rb");
+	TestLatencyTiming<RBTreeTopDown>(insertKeys, "rbTopDown");
+	TestLatencyTiming<ScapegoatTree>(insertKeys, "scapegoat");
+	TestLatencyTiming<SplayTree>(insertKeys, "splay");
+	TestLatencyTiming<BitmapSet>(insertKeys, "bitmap");
+	TestLatencyTiming<AdaptiveRadixTree>(insertKeys, "art");
+	TestLatencyTiming<BEpsilonTree>(insertKeys, "bEpsilon");
+	TestLatencyTiming<LSMTree>(insertKeys, "lsm");
+	std::cout << "Test p99.9 latency of " << insertSize << " keys by allocation and rebalance steps, ns (share of ops)" << '\n';
+	if (!AllocationsCounted())
+	{
+		std::cout << "Allocations are not counted, define COUNT_ALLOCATIONS to split by them" << '\n';
+	}
+	std::cout << std::left << std::setw(10) << "tree" << std::setw(10) << "op" << std::setw(20) << "no alloc" << std::setw(20) << "alloc"
+		<< std::setw(20) << "depth 0" << std::setw(20) << "depth 1" << std::setw(20) << "depth 2-3" << std::setw(20) << "depth 4+" << '\n';
+	TestLatencyAttribution<AVLTreeIterative>(insertKeys, "avlIter");
+	TestLatencyAttribution<RBTree>(insertKeys, "rb");
+
+	// test find timings with uniform and skewed (zipfian) access to the same keys
+	const size_t hotSize = 16;
+	std::vector<int> hotKeys(controlSet.cbegin(), controlSet.cend());
+	std::shuffle(hotKeys.begin(), hotKeys.end(), gen);
+	ZipfDistribution zipf(hotKeys.size());
+	std::vector<int> uniformFindKeys;
+	std::vector<int> zipfFindKeys;
+	uniformFindKeys.reserve(findSize);
+	zipfFindKeys.reserve(findSize);
+	for (int i = 0; i < findSize; i++)
+	{
+		uniformFindKeys.push_back(hotKeys[gen() % hotKeys.size()]);
+		zipfFindKeys.push_back(hotKeys[zipf(gen)]);
+	}
+
+	std::cout << "Test find with uniform and zipfian access, " << hotKeys.size() << " elements" << '\n';
+	std::cout << std::left << std::setw(10) << "tree" << std::setw(20) << "uniform, ns" << std::setw(20) << "zipf, ns" << '\n';
+	TestSkewedFindTiming<AVLTreeIterative>(insertKeys, uniformFindKeys, zipfFindKeys, "avlIter");
+	TestSkewedFindTiming<RBTree>(insertKeys, uniformFindKeys, zipfFindKeys, "rb");
+	TestSkewedFindTiming<SplayTree>(insertKeys, uniformFindKeys, zipfFindKeys, "splay");
+
+	// hot keys move to the top of splay tree
+	double hotDepthBefore = 0.0;
+	double hotDepthAfter = 0.0;
+	for (size_t i = 0; i < hotSize; i++)
+	{
+		hotDepthBefore += splay.Depth(hotKeys[i]);
+	}
+	FindTiming(splay, zipfFindKeys);
+	for (size_t i = 0; i < hotSize; i++)
+	{
+		hotDepthAfter += splay.Depth(hotKeys[i]);
+	}
+	std::cout << "Average depth of " << hotSize << " hottest keys in splay: " << hotDepthBefore / hotSize << " before zipf finds, " << hotDepthAfter / hotSize << " after" << '\n';
+
+	// test find timings with hot-key front cache
+	std::cout << "Test find with front cache, uniform and zipfian access" << '\n';
+	std::cout << std::left << std::setw(10) << "tree" << std::setw(20) << "uniform, ns" << std::setw(20) << "zipf, ns" << std::setw(20) << "zipf hit rate" << '\n';
+	TestCachedFindTiming<AVLTree>(insertKeys, uniformFindKeys, zipfFindKeys, "avlRec");
+	TestCachedFindTiming<AVLTreeIterative>(insertKeys, uniformFindKeys, zipfFindKeys, "avlIter");
+	TestCachedFindTiming<RBTree>(insertKeys, uniformFindKeys, zipfFindKeys, "rb");
+
+	// test find timings with membership filter when most of finds miss
+	std::vector<int> absentKeys;
+	absentKeys.reserve(findSize);
+	while (absentKeys.size() < findSize)
+	{
+		int rndInt = dist(gen);
+		if (controlSet.count(rndInt) == 0)
+		{
+			absentKeys.push_back(rndInt);
+		}
+	}
+
+	RBTree rbPlain;
+	AVLTreeIterative avlIterPlain;
+	FilteredTree<RBTree> rbFiltered(controlSet.size());
+	FilteredTree<AVLTreeIterative> avlIterFiltered(controlSet.size());
+	PrepareSomeTree(rbPlain, insertKeys);
+	PrepareSomeTree(avlIterPlain, insertKeys);
+	PrepareSomeTree(rbFiltered, insertKeys);
+	PrepareSomeTree(avlIterFiltered, insertKeys);
+
+	std::cout << "Test find with membership filter, " << static_cast<double>(rbFiltered.FilterMemoryUsage()) / controlSet.size() << " filter bytes per key" << '\n';
+	std::cout << std::left << std::setw(10) << "hit ratio" << std::setw(20) << "rb, ns" << std::setw(20) << "rb+filter, ns" << std::setw(20) << "avlIter, ns" << std::setw(20) << "avlIter+filter, ns" << std::setw(20) << "false positives" << '\n';
+	for (double hitRatio : { 0.0, 0.1, 0.5, 0.9 })
+	{
+		std::vector<int> mixedFindKeys;
+		mixedFindKeys.reserve(findSize);
+		for (int i = 0; i < findSize; i++)
+		{
+			bool hit = i < hitRatio * findSize;
+			mixedFindKeys.push_back(hit ? uniformFindKeys[i] : absentKeys[i]);
+		}
+		std::shuffle(mixedFindKeys.begin(), mixedFindKeys.end(), gen);
+
+		rbFiltered.ResetCounters();
+		std::cout << std::left << std::setw(10) << hitRatio
+			<< std::setw(20) << FindTiming(rbPlain, mixedFindKeys)
+			<< std::setw(20) << FindTiming(rbFiltered, mixedFindKeys)
+			<< std::setw(20) << FindTiming(avlIterPlain, mixedFindKeys)
+			<< std::setw(20) << FindTiming(avlIterFiltered, mixedFindKeys)
+			<< std::setw(20) << static_cast<double>(rbFiltered.FalsePositives()) / (findSize - hitRatio * findSize) << '\n';
+	}
+
+	// test removing a range of consecutive keys
+	const size_t rangeSize = std::min<size_t>(100'000, controlSet.size() / 2);
+	std::vector<int> sortedKeys(controlSet.cbegin(), controlSet.cend());
+	size_t rangeStart = (sortedKeys.size() - rangeSize) / 2;
+	std::vector<int> rangeKeys(sortedKeys.cbegin() + rangeStart, sortedKeys.cbegin() + rangeStart + rangeSize);
+
+	std::cout << "Test remove range of " << rangeSize << " elements" << '\n';
+	std::cout << std::left << std::setw(10) << "tree" << std::setw(20) << "remove by key, ms" << std::setw(20) << "RemoveRange, ms" << std::setw(20) << "ExtractRange, ms" << '\n';
+	TestRangeTiming<AVLTreeIterative>(insertKeys, rangeKeys, "avlIter");
+	TestRangeTiming<RBTree>(insertKeys, rangeKeys, "rb");
+
+	std::set<int> rangeControlSet(controlSet);
+	rangeControlSet.erase(rangeControlSet.find(rangeKeys.front()), ++rangeControlSet.find(rangeKeys.back()));
+	avlIter.RemoveRange(rangeKeys.front(), rangeKeys.back());
+	rb.RemoveRange(rangeKeys.front(), rangeKeys.back());
+	CheckEquality(avlIter, rangeControlSet, "avlIter after RemoveRange");
+	CheckEquality(rb, rangeControlSet, "rb after RemoveRange");
+
+	// test nearest key queries
+	std::vector<int> nearestKeys;
+	nearestKeys.reserve(findSize);
+	for (int i = 0; i < findSize; i++)
+	{
+		nearestKeys.push_back(dist(gen));
+	}
+	std::vector<int> sortedNearestKeys(nearestKeys);
+	std::sort(sortedNearestKeys.begin(), sortedNearestKeys.end());
+
+	std::cout << "Test floor with " << findSize << " probes" << '\n';
+	std::cout << std::left << std::setw(10) << "tree" << std::setw(20) << "GetVector, ms" << std::setw(20) << "vector search, ns" << std::setw(20) << "Floor, ns" << std::setw(20) << "sorted Floor, ns" << std::setw(20) << "batch Floor, ns" << '\n';
+	TestNearestTiming<AVLTree>(insertKeys, nearestKeys, sortedNearestKeys, "avlRec");
+	TestNearestTiming<AVLTreeIterative>(insertKeys, nearestKeys, sortedNearestKeys, "avlIter");
+	TestNearestTiming<RBTree>(insertKeys, nearestKeys, sortedNearestKeys, "rb");
+
+	// rb and avlIter have a range removed
+	std::vector<int> floorResults;
+	std::vector<bool> floorFound;
+	bool isNearestEqual = true;
+	rb.Floor(sortedNearestKeys, floorResults, floorFound);
+	for (size_t i = 0; i < sortedNearestKeys.size(); i++)
+	{
+		int result = 0;
+		auto it = controlSet.upper_bound(sortedNearestKeys[i]);
+		bool exists = it != controlSet.cbegin();
+		isNearestEqual = isNearestEqual && avlRec.Floor(sortedNearestKeys[i], result) == exists && (!exists || result == *std::prev(it));
+		it = rangeControlSet.upper_bound(sortedNearestKeys[i]);
+		exists = it != rangeControlSet.cbegin();
+		isNearestEqual = isNearestEqual && floorFound[i] == exists && (!exists || floorResults[i] == *std::prev(it));
+		exists = it != rangeControlSet.cend();
+		isNearestEqual = isNearestEqual && avlIter.Successor(sortedNearestKeys[i], result) == exists && (!exists || result == *it);
+	}
+	std::cout << "Do nearest keys agree with std::set? " << (isNearestEqual ? "yes" : "no") << '\n';
+
+	// test overlap queries
+	TestIntervalTree(insertKeys, gen);
+
+	// test range aggregates
+	TestAggregate<AugmentedAVLTree>(insertKeys, gen, "avl");
+	TestAggregate<AugmentedRBTree>(insertKeys, gen, "rb");
+
+	// test duplicate keys
+	for (int distinctKeys : { 1'000, 100'000 })
+	{
+		TestMultiset(insertSize, distinctKeys, gen);
+	}
+
+	// test concurrent access
+	std::cout << "Is concurrent avl consistent with std::set under stress? " << (StressConcurrentTree(std::max(4u, std::thread::hardware_concurrency()), 200'000, 10'000) ? "yes" : "no") << '\n';
+	TestConcurrentTiming(insertKeys, uniformFindKeys);
+
+	// test transactional batches of writes
+	TestTransactions(insertKeys, uniformFindKeys);
+	std::cout << "Do readers see transactions atomically? " << (CheckTransactionAtomicity(10'000) ? "yes" : "no") << '\n';
+
+	// test per-node replicas fed by operation log, small log and extra replicas exercise it on a single node
+	std::cout << "Are rb replicas consistent with std::set under stress? " << (StressReplicatedTree<RBTree>(3, 1'024, 100'000, 10'000) ? "yes" : "no") << '\n';
+	std::cout << "Are avlIter replicas consistent with std::set under stress? " << (StressReplicatedTree<AVLTreeIterative>(3, 1'024, 100'000, 10'000) ? "yes" : "no") << '\n';
+	std::cout << "Test replicated find, " << NumaTopology().NumNodes() << " NUMA nodes" << '\n';
+	std::cout << std::left << std::setw(10) << "tree" << std::setw(20) << "write, ns" << std::setw(20) << "find, ns" << std::setw(20) << "replicated write" << std::setw(20) << "replicated find" << std::setw(20) << "replayed per write" << '\n';
+	TestReplicatedTiming<RBTree>(insertKeys, uniformFindKeys, "rb");
+	TestReplicatedTiming<AVLTreeIterative>(insertKeys, uniformFindKeys, "avlIter");
+
+	// test construction from unsorted keys
+	unsigned int buildThreads = std::max(1u, std::thread::hardware_concurrency());
+	for (int buildSize : { 1'000'000, 10'000'000 })
+	{
+		std::uniform_int_distribution<int> buildDist(0, 10 * buildSize);
+		std::vector<int> buildKeys;
+		buildKeys.reserve(buildSize);
+		for (int i = 0; i < buildSize; i++)
+		{
+			buildKeys.push_back(buildDist(gen));
+		}
+		std::chrono::high_resolution_clock::time_point t1, t2;
+		t1 = std::chrono::high_resolution_clock::now();
+		std::set<int> buildControlSet(buildKeys.cbegin(), buildKeys.cend());
+		t2 = std::chrono::high_resolution_clock::now();
+
+		std::cout << "Test build from " << buildSize << " unsorted keys, std::set construction takes " << std::chrono::duration<double, std::milli>(t2 - t1).count() << " ms" << '\n';
+		std::cout << std::left << std::setw(10) << "tree" << std::setw(20) << "Insert, ms" << std::setw(20) << "1 thread, ms" << std::setw(20) << (std::to_string(buildThreads) + " threads, ms") << '\n';
+		bool isBuildEqual = TestBuildTiming<RBTree>(buildKeys, buildControlSet, buildThreads, "rb");
+		isBuildEqual = TestBuildTiming<AVLTreeIterative>(buildKeys, buildControlSet, buildThreads, "avlIter") && isBuildEqual;
+		std::cout << "Do built trees and std::set agree? " << (isBuildEqual ? "yes" : "no") << '\n';
+	}
+
+	// test find timings and memory per key
+	for (int treeSize : { 1'000'000, 10'000'000 })
+	{
+		std::uniform_int_distribution<int> treeDist(0, 10 * treeSize);
+		std::vector<int> treeKeys;
+		treeKeys.reserve(treeSize);
+		for (int i = 0; i < treeSize; i++)
+		{
+			treeKeys.push_back(treeDist(gen));
+		}
+		// half of probes hit, half are random
+		std::vector<int> findKeys;
+		findKeys.reserve(findSize);
+		for (int i = 0; i < findSize; i++)
+		{
+			findKeys.push_back(i % 2 == 0 ? treeKeys[gen() % treeSize] : treeDist(gen));
+		}
+
+		std::cout << "Test find with " << treeSize << " elements" << '\n';
+		std::cout << std::left << std::setw(10) << "tree" << std::setw(20) << "bytes per key" << std::setw(20) << "find, ns" << '\n';
+		TestFindTiming<AVLTree>(treeKeys, findKeys, "avlRec");
+		TestFindTiming<AVLTreeIterative>(treeKeys, findKeys, "avlIter");
+		TestFindTiming<AVLTreeHotCold>(treeKeys, findKeys, "hotCold");
+		TestFindTiming<RBTree>(treeKeys, findKeys, "rb");
+		TestFindTiming<RBTreeTopDown>(treeKeys, findKeys, "rbTopDown");
+		TestFindTiming<ScapegoatTree>(treeKeys, findKeys, "scapegoat");
+		TestFindTiming<SplayTree>(treeKeys, findKeys, "splay");
+		TestFindTiming<BitmapSet>(treeKeys, findKeys, "bitmap");
+		TestFindTiming<AdaptiveRadixTree>(treeKeys, findKeys, "art");
+		TestFindTiming<BEpsilonTree>(treeKeys, findKeys, "bEpsilon");
+		TestFindTiming<LSMTree>(treeKeys, findKeys, "lsm");
+
+		std::cout << "Test batched find with " << treeSize << " elements" << '\n';
+		std::cout << std::left << std::setw(10) << "tree" << std::setw(20) << "find, ns" << std::setw(20) << "FindBatch, ns" << std::setw(20) << "co_await find, ns" << '\n';
+		bool isBatchEqual = TestBatchFindTiming<AVLTree>(treeKeys, findKeys, "avlRec");
+		isBatchEqual = TestBatchFindTiming<AVLTreeIterative>(treeKeys, findKeys, "avlIter") && isBatchEqual;
+		isBatchEqual = TestBatchFindTiming<RBTree>(treeKeys, findKeys, "rb") && isBatchEqual;
+		std::cout << "Do batched finds agree with Find? " << (isBatchEqual ? "yes" : "no") << '\n';
+
+		// half of keys are replaced by new ones in random order
+		std::vector<int> churnKeys;
+		churnKeys.reserve(treeSize / 2);
+		for (int i = 0; i < treeSize / 2; i++)
+		{
+			churnKeys.push_back(treeDist(gen));
+		}
+		std::cout << "Test find before and after Compact with " << treeSize << " elements, half of them replaced" << '\n';
+		std::cout << std::left << std::setw(10) << "tree" << std::setw(20) << "find, ns" << std::setw(20) << "Compact, ms" << std::setw(20) << "compacted find, ns" << std::setw(20) << "speedup" << '\n';
+		TestCompactTiming<AVLTreeIterative>(treeKeys, churnKeys, findKeys, "avlIter");
+		TestCompactTiming<RBTree>(treeKeys, churnKeys, findKeys, "rb");
+
+		std::cout << "Test 90% insert/remove, 10% find with " << treeSize << " elements" << '\n';
+		std::cout << std::left << std::setw(10) << "tree" << std::setw(20) << "op, ns" << '\n';
+		bool isMixedEqual = TestMixedTiming<RBTree>(treeKeys, findKeys, 90, "rb");
+		isMixedEqual = TestMixedTiming<BEpsilonTree>(treeKeys, findKeys, 90, "bEpsilon") && isMixedEqual;
+		isMixedEqual = TestMixedTiming<LSMTree>(treeKeys, findKeys, 90, "lsm") && isMixedEqual;
+		std::cout << "Do trees after mixed ops and std::set agree? " << (isMixedEqual ? "yes" : "no") << '\n';
+	}
+
+	// test find with nodes on huge pages
+	for (int treeSize : { 1'000'000, 10'000'000, 50'000'000 })
+	{
+		std::uniform_int_distribution<int> treeDist(0, 10 * treeSize);
+		std::vector<int> treeKeys;
+		treeKeys.reserve(treeSize);
+		for (int i = 0; i < treeSize; i++)
+		{
+			treeKeys.push_back(treeDist(gen));
+		}
+		std::vector<int> findKeys;
+		findKeys.reserve(findSize);
+		for (int i = 0; i < findSize; i++)
+		{
+			findKeys.push_back(i % 2 == 0 ? treeKeys[gen() % treeSize] : treeDist(gen));
+		}
+
+		std::cout << "Test find on huge pages with " << treeSize << " elements" << '\n';
+		std::cout << std::left << std::setw(10) << "tree" << std::setw(20) << "find, ns" << std::setw(20) << "huge pages find, ns" << std::setw(20) << "on huge pages" << '\n';
+		TestHugePageTiming<AVLTreeIterative>(treeKeys, findKeys, "avlIter");
+		TestHugePageTiming<RBTree>(treeKeys, findKeys, "rb");
+	}
+}
+
+template <typename T> void TestTreeTiming(T& tree, std::vector<int>& keys, std::pair<double, double>& times)
+{
+	double insertTime = 0.0;
+	double removeTime = 0.0;
+	std::chrono::high_resolution_clock::time_point t1, t2;
+
+	t1 = std::chrono::high_resolution_clock::now();
+	for (auto& value : keys)
+	{
+		Insert(tree, value);
+	}
+	t2 = std::chrono::high_resolution_clock::now();
+	insertTime += std::chrono::duration<double, std::milli>(t2 - t1).count();
+
+	t1 = std::chrono::high_resolution_clock::now();
+	for (auto& value : keys)
+	{
+		Remove(tree, value);
+	}
+	t2 = std::chrono::high_resolution_clock::now();
+	removeTime += std::chrono::duration<double, std::milli>(t2 - t1).count();
+
+	times.first += insertTime;
+	times.second += removeTime;
+}
+
+// every key is inserted, found and removed; prints time and hardware counters per operation of each phase
+template <typename T> void TestCounterTiming(std::vector<int>& keys, const char* name)
+{
+	T tree;
+	PerfCounters counters;
+	size_t found = 0;
+	auto measure = [&keys, &counters, name](const char* phaseName, auto phase)
+	{
+		std::chrono::high_resolution_clock::time_point t1, t2;
+		counters.Start();
+		t1 = std::chrono::high_resolution_clock::now();
+		for (int value : keys)
+		{
+			phase(value);
+		}
+		t2 = std::chrono::high_resolution_clock::now();
+		counters.Stop();
+		std::cout << std::left << std::setw(10) << name << std::setw(10) << phaseName << std::setw(10) << std::chrono::duration<double, std::nano>(t2 - t1).count() / keys.size();
+		for (size_t i = 0; i < PerfCounters::eventCount; i++)
+		{
+			auto event = static_cast<PerfCounters::Event>(i);
+			if (counters.Available(event))
+			{
+				std::cout << std::setw(10) << counters.Count(event) / keys.size();
+			}
+			else
+			{
+				std::cout << std::setw(10) << "n/a";
+			}
+		}
+		std::cout << '\n';
+	};
+	measure("insert", [&tree](int value) { Insert(tree, value); });
+	measure("find", [&tree, &found](int value) { found += Find(tree, value) ? 1 : 0; });
+	measure("remove", [&tree](int value) { Remove(tree, value); });
+	// keep the finds from being optimized away
+	if (found > keys.size())
+	{
+		std::cout << found;
+	}
+}
+
+// the tree is emptied by Clear after removing half of keys, then by removing all of them;
+// both times nothing must be found or counted
+template <typename T> bool CheckEmptiedTree(std::vector<int>& keys)
+{
+	T tree;
+	bool isEmpty = true;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		for (int value : keys)
+		{
+			tree.Insert(value);
+		}
+		size_t removeCount = pass == 0 ? keys.size() / 2 : keys.size();
+		for (size_t i = 0; i < removeCount; i++)
+		{
+			tree.Remove(keys[i]);
+		}
+		if (pass == 0)
+		{
+			tree.Clear();
+		}
+		isEmpty = isEmpty && tree.GetVector().empty();
+		for (int value : keys)
+		{
+			isEmpty = isEmpty && !tree.Find(value) && tree.Count(value) == 0;
+		}
+	}
+	return isEmpty;
+}
+
+template <typename T> void CheckEquality(T& tree, std::set<int>& controlSet, const char* name)
+{
+	std::vector<int> treeValues = tree.GetVector();
+	bool isEqual = std::equal(treeValues.cbegin(), treeValues.cend(), controlSet.cbegin());
+	std::cout << "Are " << name << " and std::set equal? " << (isEqual ? "yes" : "no") << '\n';
+}
+
+template <typename T> inline void Insert(T& tree, int value)
+{
+	tree.Insert(value);
+}
+
+template <> inline void Insert<std::set<int>>(std::set<int>& tree, int value)
+{
+	tree.insert(value);
+}
+
+template <typename T> inline void Remove(T& tree, int value)
+{
+	tree.Remove(value);
+}
+
+template <> inline void Remove<std::set<int>>(std::set<int>& tree, int value)
+{
+	tree.erase(value);
+}
+
+template <typename T> inline bool Find(T& tree, int value)
+{
+	return tree.Find(value);
+}
+
+template <> inline bool Find<std::set<int>>(std::set<int>& tree, int value)
+{
+	return tree.find(value) != tree.end();
+}
+
+template <typename T> void PrepareSomeTree(T& tree, std::vector<int>& keys)
+{
+	for (int value : keys)
+	{
+		Insert(tree, value);
+	}
+	for (size_t i = 0; i < keys.size(); i += 2)
+	{
+		Remove(tree, keys[i]);
+	}
+}
+
+template <typename T> void TestFindTiming(std::vector<int>& keys, std::vector<int>& probes, const char* name)
+{
+	T tree;
+	for (int value : keys)
+	{
+		Insert(tree, value);
+	}
+
+	double findTime = FindTiming(tree, probes);
+	double bytesPerKey = static_cast<double>(tree.MemoryUsage()) / tree.GetVector().size();
+	std::cout << std::left << std::setw(10) << name << std::setw(20) << bytesPerKey << std::setw(20) << findTime << '\n';
+}
+
+template <typename T> void TestSkewedFindTiming(std::vector<int>& keys, std::vector<int>& uniformProbes, std::vector<int>& zipfProbes, const char* name)
+{
+	T tree;
+	PrepareSomeTree(tree, keys);
+
+	double uniformTime = FindTiming(tree, uniformProbes);
+	double zipfTime = FindTiming(tree, zipfProbes);
+	std::cout << std::left << std::setw(10) << name << std::setw(20) << uniformTime << std::setw(20) << zipfTime << '\n';
+}
+
+template <typename T> void TestCachedFindTiming(std::vector<int>& keys, std::vector<int>& uniformProbes, std::vector<int>& zipfProbes, const char* name)
+{
+	CachedTree<T> tree;
+	PrepareSomeTree(tree, keys);
+
+	double uniformTime = FindTiming(tree, uniformProbes);
+	tree.ResetCounters();
+	double zipfTime = FindTiming(tree, zipfProbes);
+	std::cout << std::left << std::setw(10) << name << std::setw(20) << uniformTime << std::setw(20) << zipfTime << std::setw(20) << tree.HitRate() << '\n';
+}
+
+template <typename T> void TestRangeTiming(std::vector<int>& keys, std::vector<int>& rangeKeys, const char* name)
+{
+	T byKeyTree;
+	T rangeTree;
+	T extractTree;
+	T extracted;
+	PrepareSomeTree(byKeyTree, keys);
+	PrepareSomeTree(rangeTree, keys);
+	PrepareSomeTree(extractTree, keys);
+
+	std::chrono::high_resolution_clock::time_point t1, t2;
+	t1 = std::chrono::high_resolution_clock::now();
+	for (int value : rangeKeys)
+	{
+		Remove(byKeyTree, value);
+	}
+	t2 = std::chrono::high_resolution_clock::now();
+	double byKeyTime = std::chrono::duration<double, std::milli>(t2 - t1).count();
+
+	t1 = std::chrono::high_resolution_clock::now();
+	rangeTree.RemoveRange(rangeKeys.front(), rangeKeys.back());
+	t2 = std::chrono::high_resolution_clock::now();
+	double rangeTime = std::chrono::duration<double, std::milli>(t2 - t1).count();
+
+	t1 = std::chrono::high_resolution_clock::now();
+	extractTree.ExtractRange(rangeKeys.front(), rangeKeys.back(), extracted);
+	t2 = std::chrono::high_resolution_clock::now();
+	double extractTime = std::chrono::duration<double, std::milli>(t2 - t1).count();
+
+	std::cout << std::left << std::setw(10) << name << std::setw(20) << byKeyTime << std::setw(20) << rangeTime << std::setw(20) << extractTime << '\n';
+}
+
+template <typename T> void TestNearestTiming(std::vector<int>& keys, std::vector<int>& probes, std::vector<int>& sortedProbes, const char* name)
+{
+	T tree;
+	PrepareSomeTree(tree, keys);
+
+	// without nearest key queries sorted vector is rebuilt after updates
+	std::chrono::high_resolution_clock::time_point t1, t2;
+	t1 = std::chrono::high_resolution_clock::now();
+	std::vector<int> sorted = tree.GetVector();
+	t2 = std::chrono::high_resolution_clock::now();
+	double vectorTime = std::chrono::duration<double, std::milli>(t2 - t1).count();
+
+	size_t checksum = 0;
+	t1 = std::chrono::high_resolution_clock::now();
+	for (int key : probes)
+	{
+		auto it = std::upper_bound(sorted.cbegin(), sorted.cend(), key);
+		checksum += it != sorted.cbegin() ? *std::prev(it) : 0;
+	}
+	t2 = std::chrono::high_resolution_clock::now();
+	double searchTime = std::chrono::duration<double, std::nano>(t2 - t1).count() / probes.size();
+
+	int result = 0;
+	t1 = std::chrono::high_resolution_clock::now();
+	for (int key : probes)
+	{
+		checksum += tree.Floor(key, result) ? result : 0;
+	}
+	t2 = std::chrono::high_resolution_clock::now();
+	double floorTime = std::chrono::duration<double, std::nano>(t2 - t1).count() / probes.size();
+
+	t1 = std::chrono::high_resolution_clock::now();
+	for (int key : sortedProbes)
+	{
+		checksum += tree.Floor(key, result) ? result : 0;
+	}
+	t2 = std::chrono::high_resolution_clock::now();
+	double sortedFloorTime = std::chrono::duration<double, std::nano>(t2 - t1).count() / sortedProbes.size();
+
+	std::vector<int> results;
+	std::vector<bool> found;
+	results.reserve(sortedProbes.size());
+	found.reserve(sortedProbes.size());
+	t1 = std::chrono::high_resolution_clock::now();
+	tree.Floor(sortedProbes, results, found);
+	t2 = std::chrono::high_resolution_clock::now();
+	double batchTime = std::chrono::duration<double, std::nano>(t2 - t1).count() / sortedProbes.size();
+
+	std::cout << std::left << std::setw(10) << name << std::setw(20) << vectorTime << std::setw(20) << searchTime << std::setw(20) << floorTime << std::setw(20) << sortedFloorTime << std::setw(20) << batchTime << '\n';
+	// keep the searches from being optimized away
+	if (checksum == 1)
+	{
+		std::cout << checksum;
+	}
+}
+
+void TestIntervalTree(std::vector<int>& keys, std::default_random_engine& gen)
+{
+	const int maxLength = 1'000;
+	const int queryLength = 100;
+	const int overlapQueries = 100'000;
+	const int scanQueries = 100;
+	std::uniform_int_distribution<int> lengthDist(0, maxLength);
+
+	// intervals start at keys
+	std::vector<std::pair<int, int>> intervals;
+	intervals.reserve(keys.size());
+	for (int key : keys)
+	{
+		intervals.emplace_back(key, key + lengthDist(gen));
+	}
+	// tree keeps equal intervals once
+	std::sort(intervals.begin(), intervals.end());
+	intervals.erase(std::unique(intervals.begin(), intervals.end()), intervals.end());
+	std::shuffle(intervals.begin(), intervals.end(), gen);
+	std::vector<int> queries;
+	queries.reserve(overlapQueries);
+	for (int i = 0; i < overlapQueries; i++)
+	{
+		queries.push_back(keys[gen() % keys.size()] + lengthDist(gen) - maxLength / 2);
+	}
+
+	IntervalTree tree;
+	std::chrono::high_resolution_clock::time_point t1, t2;
+	t1 = std::chrono::high_resolution_clock::now();
+	for (auto& interval : intervals)
+	{
+		tree.Insert(interval.first, interval.second);
+	}
+	t2 = std::chrono::high_resolution_clock::now();
+	double insertTime = std::chrono::duration<double, std::milli>(t2 - t1).count();
+
+	size_t overlaps = 0;
+	t1 = std::chrono::high_resolution_clock::now();
+	for (int lo : queries)
+	{
+		tree.FindOverlapping(lo, lo + queryLength, [&overlaps](int, int) { overlaps++; });
+	}
+	t2 = std::chrono::high_resolution_clock::now();
+	double overlapTime = std::chrono::duration<double, std::nano>(t2 - t1).count() / overlapQueries;
+
+	size_t anyOverlaps = 0;
+	t1 = std::chrono::high_resolution_clock::now();
+	for (int lo : queries)
+	{
+		anyOverlaps += tree.AnyOverlap(lo, lo + queryLength) ? 1 : 0;
+	}
+	t2 = std::chrono::high_resolution_clock::now();
+	double anyOverlapTime = std::chrono::duration<double, std::nano>(t2 - t1).count() / overlapQueries;
+
+	// full scan, the way it was done without the tree
+	bool isEqual = true;
+	t1 = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < scanQueries; i++)
+	{
+		int lo = queries[i];
+		int hi = lo + queryLength;
+		size_t scanned = std::count_if(intervals.cbegin(), intervals.cend(), [lo, hi](const std::pair<int, int>& interval)
+		{
+			return interval.first <= hi && lo <= interval.second;
+		});
+		size_t found = 0;
+		tree.FindOverlapping(lo, hi, [&found](int, int) { found++; });
+		isEqual = isEqual && found == scanned;
+	}
+	t2 = std::chrono::high_resolution_clock::now();
+	double scanTime = std::chrono::duration<double, std::nano>(t2 - t1).count() / scanQueries;
+
+	std::cout << "Test interval tree with " << intervals.size() << " intervals" << '\n';
+	std::cout << std::left << std::setw(20) << "insert, ms" << std::setw(20) << "overlapping, ns" << std::setw(20) << "any overlap, ns" << std::setw(20) << "full scan, ns" << std::setw(20) << "avg overlaps" << '\n';
+	std::cout << std::left << std::setw(20) << insertTime << std::setw(20) << overlapTime << std::setw(20) << anyOverlapTime << std::setw(20) << scanTime << std::setw(20) << static_cast<double>(overlaps) / overlapQueries << '\n';
+	std::cout << "Do interval tree and full scan agree? " << (isEqual ? "yes" : "no") << '\n';
+}
+
+template <template <typename> class Tree> void TestAggregate(std::vector<int>& keys, std::default_random_engine& gen, const char* name)
+{
+	const int maxValue = 1'000;
+	const int aggregateQueries = 100'000;
+	const int scanQueries = 100;
+	std::uniform_int_distribution<int> valueDist(0, maxValue);
+
+	// every key gets a value, later inserts replace earlier ones
+	std::map<int, int> control;
+	Tree<SumMonoid> sumTree;
+	Tree<MinMonoid> minTree;
+	std::chrono::high_resolution_clock::time_point t1, t2;
+	t1 = std::chrono::high_resolution_clock::now();
+	for (int key : keys)
+	{
+		int value = valueDist(gen);
+		sumTree.Insert(key, value);
+		minTree.Insert(key, value);
+		control[key] = value;
+	}
+	t2 = std::chrono::high_resolution_clock::now();
+	double insertTime = std::chrono::duration<double, std::milli>(t2 - t1).count();
+
+	// ranges cover about 1% of keys
+	int keyMin = control.cbegin()->first;
+	int keyMax = control.crbegin()->first;
+	int rangeLength = (keyMax - keyMin) / 100;
+	std::uniform_int_distribution<int> loDist(keyMin, keyMax - rangeLength);
+	std::vector<int> queries;
+	queries.reserve(aggregateQueries);
+	for (int i = 0; i < aggregateQueries; i++)
+	{
+		queries.push_back(loDist(gen));
+	}
+
+	long long checksum = 0;
+	t1 = std::chrono::high_resolution_clock::now();
+	for (int lo : queries)
+	{
+		checksum += sumTree.Aggregate(lo, lo + rangeLength);
+	}
+	t2 = std::chrono::high_resolution_clock::now();
+	double sumTime = std::chrono::duration<double, std::nano>(t2 - t1).count() / aggregateQueries;
+
+	t1 = std::chrono::high_resolution_clock::now();
+	for (int lo : queries)
+	{
+		checksum += minTree.Aggregate(lo, lo + rangeLength);
+	}
+	t2 = std::chrono::high_resolution_clock::now();
+	double minTime = std::chrono::duration<double, std::nano>(t2 - t1).count() / aggregateQueries;
+
+	// scan of the range in an ordered map
+	bool isEqual = true;
+	t1 = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < scanQueries; i++)
+	{
+		int lo = queries[i];
+		int hi = lo + rangeLength;
+		long long sum = 0;
+		int min = MinMonoid::Identity();
+		for (auto it = control.lower_bound(lo); it != control.cend() && it->first <= hi; ++it)
+		{
+			sum += it->second;
+			min = std::min(min, it->second);
+		}
+		isEqual = isEqual && sum == sumTree.Aggregate(lo, hi) && min == minTree.Aggregate(lo, hi);
+	}
+	t2 = std::chrono::high_resolution_clock::now();
+	double scanTime = std::chrono::duration<double, std::nano>(t2 - t1).count() / scanQueries;
+
+	// aggregates must follow removals
+	size_t numKeys = control.size();
+	for (size_t i = 0; i < keys.size(); i += 2)
+	{
+		sumTree.Remove(keys[i]);
+		minTree.Remove(keys[i]);
+		control.erase(keys[i]);
+	}
+	for (int i = 0; i < scanQueries; i++)
+	{
+		int lo = queries[i];
+		int hi = lo + rangeLength;
+		long long sum = 0;
+		int min = MinMonoid::Identity();
+		for (auto it = control.lower_bound(lo); it != control.cend() && it->first <= hi; ++it)
+		{
+			sum += it->second;
+			min = std::min(min, it->second);
+		}
+		isEqual = isEqual && sum == sumTree.Aggregate(lo, hi) && min == minTree.Aggregate(lo, hi);
+	}
+
+	std::cout << "Test range aggregates in " << name << " with " << numKeys << " keys, ranges of " << rangeLength << '\n';
+	std::cout << std::left << std::setw(20) << "insert, ms" << std::setw(20) << "sum, ns" << std::setw(20) << "min, ns" << std::setw(20) << "map scan, ns" << '\n';
+	std::cout << std::left << std::setw(20) << insertTime << std::setw(20) << sumTime << std::setw(20) << minTime << std::setw(20) << scanTime << '\n';
+	std::cout << "Do " << name << " aggregates and map scan agree? " << (isEqual ? "yes" : "no") << " (checksum " << checksum << ")" << '\n';
+}
+
+template <typename T, typename InsertOp, typename CountOp, typename RemoveOp> double MultisetTiming(std::vector<int>& keys, std::vector<int>& probes, T& tree,
+	InsertOp insert, CountOp count, RemoveOp remove, std::pair<double, double>& times, size_t& checksum)
+{
+	std::chrono::high_resolution_clock::time_point t1, t2;
+	t1 = std::chrono::high_resolution_clock::now();
+	for (int key : keys)
+	{
+		insert(tree, key);
+	}
+	t2 = std::chrono::high_resolution_clock::now();
+	times.first = std::chrono::duration<double, std::milli>(t2 - t1).count();
+
+	t1 = std::chrono::high_resolution_clock::now();
+	for (int key : probes)
+	{
+		checksum += count(tree, key);
+	}
+	t2 = std::chrono::high_resolution_clock::now();
+	double countTime = std::chrono::duration<double, std::nano>(t2 - t1).count() / probes.size();
+
+	t1 = std::chrono::high_resolution_clock::now();
+	for (int key : keys)
+	{
+		remove(tree, key);
+	}
+	t2 = std::chrono::high_resolution_clock::now();
+	times.second = std::chrono::duration<double, std::milli>(t2 - t1).count();
+	return countTime;
+}
+
+void TestMultiset(size_t numKeys, int distinctKeys, std::default_random_engine& gen)
+{
+	const int countQueries = 1'000'000;
+	std::uniform_int_distribution<int> keyDist(0, distinctKeys - 1);
+	std::vector<int> keys;
+	keys.reserve(numKeys);
+	for (size_t i = 0; i < numKeys; i++)
+	{
+		keys.push_back(keyDist(gen));
+	}
+	std::vector<int> probes;
+	probes.reserve(countQueries);
+	for (int i = 0; i < countQueries; i++)
+	{
+		probes.push_back(keyDist(gen));
+	}
+
+	std::multiset<int> stdMultiset;
+	std::map<int, int> stdMap;
+	RBTree rb(true);
+	AVLTreeIterative avlIter(true);
+	std::pair<double, double> stdMultisetTimes, stdMapTimes, rbTimes, avlIterTimes;
+	size_t stdMultisetSum = 0, stdMapSum = 0, rbSum = 0, avlIterSum = 0;
+
+	double stdMultisetCount = MultisetTiming(keys, probes, stdMultiset,
+		[](std::multiset<int>& tree, int key) { tree.insert(key); },
+		[](std::multiset<int>& tree, int key) { return tree.count(key); },
+		[](std::multiset<int>& tree, int key) { auto it = tree.find(key); if (it != tree.end()) tree.erase(it); },
+		stdMultisetTimes, stdMultisetSum);
+	double stdMapCount = MultisetTiming(keys, probes, stdMap,
+		[](std::map<int, int>& tree, int key) { tree[key]++; },
+		[](std::map<int, int>& tree, int key) { auto it = tree.find(key); return it == tree.end() ? size_t(0) : size_t(it->second); },
+		[](std::map<int, int>& tree, int key) { auto it = tree.find(key); if (it != tree.end() && --it->second == 0) tree.erase(it); },
+		stdMapTimes, stdMapSum);
+	double rbCount = MultisetTiming(keys, probes, rb,
+		[](RBTree& tree, int key) { tree.Insert(key); },
+		[](RBTree& tree, int key) { return size_t(tree.Count(key)); },
+		[](RBTree& tree, int key) { tree.Remove(key); },
+		rbTimes, rbSum);
+	double avlIterCount = MultisetTiming(keys, probes, avlIter,
+		[](AVLTreeIterative& tree, int key) { tree.Insert(key); },
+		[](AVLTreeIterative& tree, int key) { return size_t(tree.Count(key)); },
+		[](AVLTreeIterative& tree, int key) { tree.Remove(key); },
+		avlIterTimes, avlIterSum);
+
+	std::cout << "Test multiset with " << numKeys << " keys, " << distinctKeys << " distinct" << '\n';
+	std::cout << std::left << std::setw(10) << "tree" << std::setw(20) << "insert, ms" << std::setw(20) << "count, ns" << std::setw(20) << "remove, ms" << '\n';
+	std::cout << std::left << std::setw(10) << "multiset" << std::setw(20) << stdMultisetTimes.first << std::setw(20) << stdMultisetCount << std::setw(20) << stdMultisetTimes.second << '\n';
+	std::cout << std::left << std::setw(10) << "map" << std::setw(20) << stdMapTimes.first << std::setw(20) << stdMapCount << std::setw(20) << stdMapTimes.second << '\n';
+	std::cout << std::left << std::setw(10) << "rb" << std::setw(20) << rbTimes.first << std::setw(20) << rbCount << std::setw(20) << rbTimes.second << '\n';
+	std::cout << std::left << std::setw(10) << "avlIter" << std::setw(20) << avlIterTimes.first << std::setw(20) << avlIterCount << std::setw(20) << avlIterTimes.second << '\n';
+	bool isEqual = stdMultisetSum == stdMapSum && stdMultisetSum == rbSum && stdMultisetSum == avlIterSum
+		&& stdMultiset.empty() && stdMap.empty() && rb.GetVector().empty() && avlIter.GetVector().empty();
+	std::cout << "Do counts agree with std::multiset? " << (isEqual ? "yes" : "no") << '\n';
+}
+
+// std::set behind a mutex, the way it is shared between threads without concurrent tree
+class MutexSet
+{
+public:
+	void Insert(int key)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		set.insert(key);
+	}
+	void Remove(int key)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		set.erase(key);
+	}
+	bool Find(int key)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return set.count(key) > 0;
+	}
+	std::vector<int> GetVector()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return std::vector<int>(set.cbegin(), set.cend());
+	}
+
+private:
+	std::mutex mutex;
+	std::set<int> set;
+};
+
+// every thread owns keys equal to its index modulo numThreads, so it knows which of them are present
+// while the other threads rotate the tree around them
+bool StressConcurrentTree(int numThreads, int opsPerThread, int keyRange)
+{
+	ConcurrentAVLTree tree;
+	MutexSet controlSet;
+	std::atomic<bool> isEqual{ true };
+	std::vector<std::thread> threads;
+	for (int t = 0; t < numThreads; t++)
+	{
+		threads.emplace_back([&, t]()
+		{
+			std::default_random_engine gen(t);
+			std::uniform_int_distribution<int> dist(0, keyRange / numThreads - 1);
+			for (int i = 0; i < opsPerThread; i++)
+			{
+				int key = dist(gen) * numThreads + t;
+				switch (gen() % 4)
+				{
+				case 0:
+					tree.Insert(key);
+					controlSet.Insert(key);
+					break;
+				case 1:
+					tree.Remove(key);
+					controlSet.Remove(key);
+					break;
+				case 2:
+					if (tree.Find(key) != controlSet.Find(key))
+					{
+						isEqual = false;
+					}
+					break;
+				default:
+					// keys of other threads, result is not known
+					tree.Find(static_cast<int>(gen() % keyRange));
+					break;
+				}
+			}
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	// balance is relaxed only while writers run
+	std::vector<int> values = tree.GetVector();
+	bool isBalanced = tree.Height() <= 1.45 * std::log2(values.size() + 2);
+	return isEqual && isBalanced && values == controlSet.GetVector();
+}
+
+template <typename T> double ConcurrentThroughput(T& tree, int numThreads, std::vector<int>& keys, std::vector<int>& probes, int writePercent)
+{
+	std::vector<std::thread> threads;
+	std::atomic<size_t> found{ 0 };
+	size_t opsPerThread = probes.size() / numThreads;
+	std::chrono::high_resolution_clock::time_point t1, t2;
+	t1 = std::chrono::high_resolution_clock::now();
+	for (int t = 0; t < numThreads; t++)
+	{
+		threads.emplace_back([&, t]()
+		{
+			size_t localFound = 0;
+			for (size_t i = t * opsPerThread; i < (t + 1) * opsPerThread; i++)
+			{
+				// writes insert and remove keys which are not in the tree
+				if (static_cast<int>(i % 100) < writePercent)
+				{
+					int key = -1 - static_cast<int>(i % keys.size());
+					tree.Insert(key);
+					tree.Remove(key);
+				}
+				else
+				{
+					localFound += tree.Find(probes[i]) ? 1 : 0;
+				}
+			}
+			found += localFound;
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	t2 = std::chrono::high_resolution_clock::now();
+	// keep the finds from being optimized away
+	if (found > probes.size())
+	{
+		std::cout << found;
+	}
+	return opsPerThread * numThreads / std::chrono::duration<double, std::micro>(t2 - t1).count();
+}
+
+void TestConcurrentTiming(std::vector<int>& keys, std::vector<int>& probes)
+{
+	ConcurrentAVLTree concurrentAvl;
+	MutexSet mutexSet;
+	PrepareSomeTree(concurrentAvl, keys);
+	PrepareSomeTree(mutexSet, keys);
+
+	std::vector<int> threadCounts;
+	// writers run concurrently, so several of them are timed even on few cores
+	int maxThreads = std::max(4u, std::thread::hardware_concurrency());
+	for (int numThreads = 1; numThreads < maxThreads; numThreads *= 2)
+	{
+		threadCounts.push_back(numThreads);
+	}
+	threadCounts.push_back(maxThreads);
+
+	std::cout << "Test concurrent throughput, million ops per second, std::set is behind a mutex" << '\n';
+	std::cout << std::left << std::setw(10) << "threads" << std::setw(20) << "avl, find" << std::setw(20) << "std::set, find" << std::setw(20) << "avl, 10% write" << std::setw(20) << "std::set, 10% write" << '\n';
+	for (int numThreads : threadCounts)
+	{
+		std::cout << std::left << std::setw(10) << numThreads
+			<< std::setw(20) << ConcurrentThroughput(concurrentAvl, numThreads, keys, probes, 0)
+			<< std::setw(20) << ConcurrentThroughput(mutexSet, numThreads, keys, probes, 0)
+			<< std::setw(20) << ConcurrentThroughput(concurrentAvl, numThreads, keys, probes, 10)
+			<< std::setw(20) << ConcurrentThroughput(mutexSet, numThreads, keys, probes, 10) << '\n';
+	}
+}
+
+void TestTransactions(std::vector<int>& keys, std::vector<int>& probes)
+{
+	std::cout << "Test transactions, insert and remove " << keys.size() << " keys, alone and while another thread finds" << '\n';
+	std::cout << std::left << std::setw(10) << "batch" << std::setw(20) << "write, ms" << std::setw(20) << "with reader, ms" << std::setw(20) << "finds meanwhile" << '\n';
+	for (size_t batchSize : { 1, 16, 256, 4096 })
+	{
+		double writeTimes[2];
+		size_t finds = 0;
+		for (bool withReader : { false, true })
+		{
+			TransactionalRBTree tree;
+			std::atomic<bool> done{ false };
+			std::thread reader([&]()
+			{
+				for (size_t i = 0; withReader && !done; i = (i + 1) % probes.size())
+				{
+					tree.Find(probes[i]);
+					finds++;
+				}
+			});
+
+			// batch of one is a plain locked write
+			TransactionalRBTree::Transaction transaction;
+			std::chrono::high_resolution_clock::time_point t1, t2;
+			t1 = std::chrono::high_resolution_clock::now();
+			for (bool insert : { true, false })
+			{
+				for (int key : keys)
+				{
+					if (batchSize == 1 && insert)
+					{
+						tree.Insert(key);
+					}
+					else if (batchSize == 1)
+					{
+						tree.Remove(key);
+					}
+					else if (insert)
+					{
+						transaction.Insert(key);
+					}
+					else
+					{
+						transaction.Remove(key);
+					}
+					if (transaction.Size() == batchSize)
+					{
+						tree.Commit(transaction);
+					}
+				}
+				tree.Commit(transaction);
+			}
+			t2 = std::chrono::high_resolution_clock::now();
+			writeTimes[withReader ? 1 : 0] = std::chrono::duration<double, std::milli>(t2 - t1).count();
+
+			done = true;
+			reader.join();
+		}
+		std::cout << std::left << std::setw(10) << batchSize << std::setw(20) << writeTimes[0] << std::setw(20) << writeTimes[1] << std::setw(20) << finds << '\n';
+	}
+}
+
+// every transaction inserts or removes both keys of a pair, readers must never see only one of them
+bool CheckTransactionAtomicity(int numTransactions)
+{
+	const int numPairs = 1'000;
+	TransactionalRBTree tree;
+	std::atomic<bool> done{ false };
+	std::atomic<bool> isAtomic{ true };
+	std::thread reader([&]()
+	{
+		while (!done)
+		{
+			std::vector<int> snapshot = tree.GetVector();
+			for (size_t i = 0; i < snapshot.size(); i++)
+			{
+				bool hasPair = snapshot[i] % 2 == 0 ? i + 1 < snapshot.size() && snapshot[i + 1] == snapshot[i] + 1 : i > 0 && snapshot[i - 1] == snapshot[i] - 1;
+				if (!hasPair)
+				{
+					isAtomic = false;
+				}
+			}
+		}
+	});
+
+	std::default_random_engine gen(0);
+	TransactionalRBTree::Transaction transaction;
+	for (int i = 0; i < numTransactions; i++)
+	{
+		for (int j = 0; j < 8; j++)
+		{
+			int key = static_cast<int>(gen() % numPairs) * 2;
+			if (gen() % 2 == 0)
+			{
+				transaction.Insert(key);
+				transaction.Insert(key + 1);
+			}
+			else
+			{
+				transaction.Remove(key + 1);
+				transaction.Remove(key);
+			}
+		}
+		tree.Commit(transaction);
+	}
+	done = true;
+	reader.join();
+	return isAtomic;
+}
+
+// writers own residue classes of keys like in StressConcurrentTree, readers find on all replicas meanwhile
+template <typename T> bool StressReplicatedTree(size_t numReplicas, size_t logCapacity, int opsPerThread, int keyRange)
+{
+	const int numWriters = 2;
+	const int numReaders = 2;
+	ReplicatedTree<T> tree(numReplicas, logCapacity);
+	std::vector<std::set<int>> controlSets(numWriters);
+	std::atomic<bool> done{ false };
+	std::vector<std::thread> threads;
+	for (int t = 0; t < numWriters; t++)
+	{
+		threads.emplace_back([&, t]()
+		{
+			std::default_random_engine gen(t);
+			std::uniform_int_distribution<int> dist(0, keyRange / numWriters - 1);
+			for (int i = 0; i < opsPerThread; i++)
+			{
+				int key = dist(gen) * numWriters + t;
+				if (gen() % 2 == 0)
+				{
+					tree.Insert(key);
+					controlSets[t].insert(key);
+				}
+				else
+				{
+					tree.Remove(key);
+					controlSets[t].erase(key);
+				}
+			}
+		});
+	}
+	for (int t = 0; t < numReaders; t++)
+	{
+		threads.emplace_back([&, t]()
+		{
+			std::default_random_engine gen(numWriters + t);
+			while (!done)
+			{
+				tree.Find(static_cast<int>(gen() % keyRange), gen() % tree.NumReplicas());
+			}
+		});
+	}
+	for (int t = 0; t < numWriters; t++)
+	{
+		threads[t].join();
+	}
+	done = true;
+	for (int t = numWriters; t < numWriters + numReaders; t++)
+	{
+		threads[t].join();
+	}
+
+	std::set<int> controlSet;
+	for (std::set<int>& set : controlSets)
+	{
+		controlSet.insert(set.cbegin(), set.cend());
+	}
+	std::vector<int> expected(controlSet.cbegin(), controlSet.cend());
+	bool isEqual = tree.GetVector() == expected;
+	for (size_t replica = 0; replica < tree.NumReplicas(); replica++)
+	{
+		isEqual = isEqual && tree.GetVector(replica) == expected;
+	}
+	return isEqual;
+}
+
+template <typename T> void TestReplicatedTiming(std::vector<int>& keys, std::vector<int>& probes, const char* name)
+{
+	// PrepareSomeTree inserts all keys and removes every other one
+	size_t numWrites = keys.size() + (keys.size() + 1) / 2;
+	T plain;
+	ReplicatedTree<T> replicated;
+	std::chrono::high_resolution_clock::time_point t1, t2;
+	t1 = std::chrono::high_resolution_clock::now();
+	PrepareSomeTree(plain, keys);
+	t2 = std::chrono::high_resolution_clock::now();
+	double writeTime = std::chrono::duration<double, std::nano>(t2 - t1).count() / numWrites;
+	t1 = std::chrono::high_resolution_clock::now();
+	PrepareSomeTree(replicated, keys);
+	t2 = std::chrono::high_resolution_clock::now();
+	double replicatedWriteTime = std::chrono::duration<double, std::nano>(t2 - t1).count() / numWrites;
+
+	// first find replays the log into local replica, keep it out of timing
+	replicated.Find(0);
+	double findTime = FindTiming(plain, probes);
+	double replicatedFindTime = FindTiming(replicated, probes);
+	std::cout << std::left << std::setw(10) << name << std::setw(20) << writeTime << std::setw(20) << findTime << std::setw(20) << replicatedWriteTime << std::setw(20) << replicatedFindTime
+		<< std::setw(20) << static_cast<double>(replicated.Replayed()) / numWrites << '\n';
+}
+
+// coroutine started eagerly and destroyed when it returns, the executor owns it while suspended
+struct DetachedTask
+{
+	struct promise_type
+	{
+		DetachedTask get_return_object() { return {}; }
+		std::suspend_never initial_suspend() { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { std::terminate(); }
+	};
+};
+
+// finds probes first, first + step, ... one co_await at a time
+template <typename T> DetachedTask FindTask(BatchExecutor<T>& executor, std::vector<int>& probes, size_t first, size_t step, std::vector<bool>& results)
+{
+	for (size_t i = first; i < probes.size(); i += step)
+	{
+		results[i] = co_await executor.Find(probes[i]);
+	}
+}
+
+// returns whether FindBatch and executor agree with Find
+template <typename T> bool TestBatchFindTiming(std::vector<int>& keys, std::vector<int>& probes, const char* name)
+{
+	T tree;
+	for (int value : keys)
+	{
+		Insert(tree, value);
+	}
+
+	double findTime = FindTiming(tree, probes);
+	std::vector<bool> batchResults;
+	std::chrono::high_resolution_clock::time_point t1, t2;
+	t1 = std::chrono::high_resolution_clock::now();
+	tree.FindBatch(probes, batchResults);
+	t2 = std::chrono::high_resolution_clock::now();
+	double batchTime = std::chrono::duration<double, std::nano>(t2 - t1).count() / probes.size();
+
+	// one task per slot of a batch, so every round of the executor is a full batch
+	const size_t numTasks = 256;
+	std::vector<bool> taskResults(probes.size());
+	BatchExecutor<T> executor(tree, numTasks);
+	t1 = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < numTasks; i++)
+	{
+		FindTask(executor, probes, i, numTasks, taskResults);
+	}
+	executor.Run();
+	t2 = std::chrono::high_resolution_clock::now();
+	double executorTime = std::chrono::duration<double, std::nano>(t2 - t1).count() / probes.size();
+	std::cout << std::left << std::setw(10) << name << std::setw(20) << findTime << std::setw(20) << batchTime << std::setw(20) << executorTime << '\n';
+
+	bool isEqual = true;
+	for (size_t i = 0; i < probes.size(); i++)
+	{
+		bool found = tree.Find(probes[i]);
+		isEqual = isEqual && batchResults[i] == found && taskResults[i] == found;
+	}
+	return isEqual;
+}
+
+// returns whether BuildParallel built the same keys as controlSet has
+template <typename T> bool TestBuildTiming(std::vector<int>& keys, std::set<int>& controlSet, unsigned int threads, const char* name)
+{
+	std::chrono::high_resolution_clock::time_point t1, t2;
+	double insertTime = 0.0;
+	{
+		T tree;
+		t1 = std::chrono::high_resolution_clock::now();
+		for (int value : keys)
+		{
+			Insert(tree, value);
+		}
+		t2 = std::chrono::high_resolution_clock::now();
+		insertTime = std::chrono::duration<double, std::milli>(t2 - t1).count();
+	}
+
+	T tree;
+	t1 = std::chrono::high_resolution_clock::now();
+	tree.BuildParallel(keys.data(), keys.size(), 1);
+	t2 = std::chrono::high_resolution_clock::now();
+	double buildTime = std::chrono::duration<double, std::milli>(t2 - t1).count();
+	t1 = std::chrono::high_resolution_clock::now();
+	tree.BuildParallel(keys.data(), keys.size(), threads);
+	t2 = std::chrono::high_resolution_clock::now();
+	double parallelBuildTime = std::chrono::duration<double, std::milli>(t2 - t1).count();
+	std::cout << std::left << std::setw(10) << name << std::setw(20) << insertTime << std::setw(20) << buildTime << std::setw(20) << parallelBuildTime << '\n';
+
+	std::vector<int> treeValues = tree.GetVector();
+	return treeValues.size() == controlSet.size() && std::equal(treeValues.cbegin(), treeValues.cend(), controlSet.cbegin());
+}
+
+template <typename T> void TestCompactTiming(std::vector<int>& keys, std::vector<int>& churnKeys, std::vector<int>& probes, const char* name)
+{
+	T tree;
+	for (int value : keys)
+	{
+		Insert(tree, value);
+	}
+	// replaced keys get nodes wherever the allocator has a hole
+	for (size_t i = 0; i < churnKeys.size() && i < keys.size(); i++)
+	{
+		Remove(tree, keys[i]);
+		Insert(tree, churnKeys[i]);
+	}
+
+	double churnedTime = FindTiming(tree, probes);
+	std::chrono::high_resolution_clock::time_point t1, t2;
+	t1 = std::chrono::high_resolution_clock::now();
+	tree.Compact();
+	t2 = std::chrono::high_resolution_clock::now();
+	double compactTime = std::chrono::duration<double, std::milli>(t2 - t1).count();
+	double compactedTime = FindTiming(tree, probes);
+	std::cout << std::left << std::setw(10) << name << std::setw(20) << churnedTime << std::setw(20) << compactTime << std::setw(20) << compactedTime
+		<< std::setw(20) << churnedTime / compactedTime << '\n';
+}
+
+template <typename T> void TestHugePageTiming(std::vector<int>& keys, std::vector<int>& probes, const char* name)
+{
+	double findTime = 0.0;
+	{
+		T tree;
+		for (int value : keys)
+		{
+			Insert(tree, value);
+		}
+		findTime = FindTiming(tree, probes);
+	}
+
+	T tree(false, true);
+	for (int value : keys)
+	{
+		Insert(tree, value);
+	}
+	double hugePageFindTime = FindTiming(tree, probes);
+	double hugePageShare = static_cast<double>(tree.HugePageBytes()) / tree.MemoryUsage();
+	std::cout << std::left << std::setw(10) << name << std::setw(20) << findTime << std::setw(20) << hugePageFindTime << std::setw(20) << std::min(hugePageShare, 1.0) << '\n';
+}
+
+// keys are inserted and then found in their order, from root and from the previous key's node;
+// returns whether both trees have the same keys
+template <typename T> bool TestNearTiming(std::vector<int>& keys, const char* name)
+{
+	T tree;
+	T nearTree;
+	std::chrono::high_resolution_clock::time_point t1, t2;
+	t1 = std::chrono::high_resolution_clock::now();
+	for (int value : keys)
+	{
+		tree.Insert(value);
+	}
+	t2 = std::chrono::high_resolution_clock::now();
+	double insertTime = std::chrono::duration<double, std::milli>(t2 - t1).count();
+	t1 = std::chrono::high_resolution_clock::now();
+	for (int value : keys)
+	{
+		nearTree.InsertNear(value);
+	}
+	t2 = std::chrono::high_resolution_clock::now();
+	double insertNearTime = std::chrono::duration<double, std::milli>(t2 - t1).count();
+
+	double findTime = FindTiming(tree, keys);
+	size_t found = 0;
+	t1 = std::chrono::high_resolution_clock::now();
+	for (int value : keys)
+	{
+		found += nearTree.FindNear(value) ? 1 : 0;
+	}
+	t2 = std::chrono::high_resolution_clock::now();
+	double findNearTime = std::chrono::duration<double, std::nano>(t2 - t1).count() / keys.size();
+	std::cout << std::left << std::setw(10) << name << std::setw(20) << insertTime << std::setw(20) << insertNearTime << std::setw(20) << findTime << std::setw(20) << findNearTime << '\n';
+
+	return found == keys.size() && tree.GetVector() == nearTree.GetVector();
+}
+
+// writePercent of ops insert or remove, the rest find; returns whether the tree ends with the keys std::set does
+template <typename T> bool TestMixedTiming(std::vector<int>& keys, std::vector<int>& opKeys, int writePercent, const char* name)
+{
+	T tree;
+	for (int value : keys)
+	{
+		Insert(tree, value);
+	}
+
+	size_t found = 0;
+	std::chrono::high_resolution_clock::time_point t1, t2;
+	t1 = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < opKeys.size(); i++)
+	{
+		if (static_cast<int>(i % 100) >= writePercent)
+		{
+			found += tree.Find(opKeys[i]) ? 1 : 0;
+		}
+		else if (i % 2 == 0)
+		{
+			Insert(tree, opKeys[i]);
+		}
+		else
+		{
+			Remove(tree, opKeys[i]);
+		}
+	}
+	t2 = std::chrono::high_resolution_clock::now();
+	// keep the finds from being optimized away
+	if (found > opKeys.size())
+	{
+		std::cout << found;
+	}
+	std::cout << std::left << std::setw(10) << name << std::setw(20) << std::chrono::duration<double, std::nano>(t2 - t1).count() / opKeys.size() << '\n';
+
+	std::set<int> controlSet(keys.cbegin(), keys.cend());
+	for (size_t i = 0; i < opKeys.size(); i++)
+	{
+		if (static_cast<int>(i % 100) < writePercent)
+		{
+			if (i % 2 == 0)
+			{
+				controlSet.insert(opKeys[i]);
+			}
+			else
+			{
+				controlSet.erase(opKeys[i]);
+			}
+		}
+	}
+	std::vector<int> treeValues = tree.GetVector();
+	return treeValues.size() == controlSet.size() && std::equal(treeValues.cbegin(), treeValues.cend(), controlSet.cbegin());
+}
+
+// every key is inserted, found and removed through tree
+template <typename T> void RunTimedOps(TimedTree<T>& tree, std::vector<int>& keys)
+{
+	for (int value : keys)
+	{
+		tree.Insert(value);
+	}
+	size_t found = 0;
+	for (int value : keys)
+	{
+		found += tree.Find(value) ? 1 : 0;
+	}
+	for (int value : keys)
+	{
+		tree.Remove(value);
+	}
+	// keep the finds from being optimized away
+	if (found > keys.size())
+	{
+		std::cout << found;
+	}
+}
+
+template <typename T> void TestLatencyTiming(std::vector<int>& keys, const char* name)
+{
+	TimedTree<T> tree;
+	RunTimedOps(tree, keys);
+	const char* operationNames[] = { "insert", "remove", "find" };
+	for (size_t i = 0; i < 3; i++)
+	{
+		const LatencyHistogram& latencies = tree.Latencies(static_cast<typename TimedTree<T>::Operation>(i));
+		std::cout << std::left << std::setw(10) << name << std::setw(10) << operationNames[i] << std::setw(20) << latencies.Percentile(50.0) << std::setw(20) << latencies.Percentile(99.0)
+			<< std::setw(20) << latencies.Percentile(99.9) << std::setw(20) << latencies.Max() << '\n';
+	}
+}
+
+// p99.9 of a part of operations and the part's share in brackets
+std::string LatencyShare(const LatencyHistogram& part, const LatencyHistogram& all)
+{
+	std::ostringstream cell;
+	cell << std::fixed << std::setprecision(0) << part.Percentile(99.9) << " (" << std::setprecision(1) << 100.0 * part.Count() / std::max<size_t>(all.Count(), 1) << "%)";
+	return cell.str();
+}
+
+template <typename T> void TestLatencyAttribution(std::vector<int>& keys, const char* name)
+{
+	TimedTree<T> tree;
+	RunTimedOps(tree, keys);
+	const char* operationNames[] = { "insert", "remove" };
+	for (size_t i = 0; i < 2; i++)
+	{
+		auto operation = static_cast<typename TimedTree<T>::Operation>(i);
+		const LatencyHistogram& latencies = tree.Latencies(operation);
+		std::cout << std::left << std::setw(10) << name << std::setw(10) << operationNames[i];
+		if (AllocationsCounted())
+		{
+			std::cout << std::setw(20) << LatencyShare(tree.AllocationLatencies(operation, false), latencies) << std::setw(20) << LatencyShare(tree.AllocationLatencies(operation, true), latencies);
+		}
+		else
+		{
+			std::cout << std::setw(20) << "n/a" << std::setw(20) << "n/a";
+		}
+		for (size_t depthClass = 0; depthClass < TimedTree<T>::depthClasses; depthClass++)
+		{
+			std::cout << std::setw(20) << LatencyShare(tree.RebalanceLatencies(operation, depthClass), latencies);
+		}
+		std::cout << '\n';
+	}
+}
+
+// returns average time of one find, ns
+template <typename T> double FindTiming(T& tree, std::vector<int>& probes)
+{
+	size_t found = 0;
+	std::chrono::high_resolution_clock::time_point t1, t2;
+	t1 = std::chrono::high_resolution_clock::now();
+	for (int value : probes)
+	{
+		found += tree.Find(value) ? 1 : 0;
+	}
+	t2 = std::chrono::high_resolution_clock::now();
+	// keep the finds from being optimized away
+	if (found > probes.size())
+	{
+		std::cout << found;
+	}
+	return std::chrono::duration<double, std::nano>(t2 - t1).count() / probes.size();
+}